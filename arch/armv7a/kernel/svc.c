@@ -24,7 +24,13 @@
 #include <kernel/fault.h>
 #include <kernel/sched.h>
 #include <kernel/sched_internals.h>
+#include <kernel/event.h>
+#include <kernel/hrtimer.h>
+#include <kernel/msg_queue.h>
 #include <kernel/mutex.h>
+#include <kernel/rwlock.h>
+#include <kernel/semaphore.h>
+#include <kernel/tasklet.h>
 #include <arch/system_regs.h>
 #include "sched_asm.h"
 
@@ -55,6 +61,8 @@ void __attribute__((section(".kernel"))) svc_handler(struct stacked_registers *r
         case SVC_END_TASK:
         case SVC_REGISTER_TASK:
         case SVC_TASK_SWITCH:
+        case SVC_SLEEP:
+        case SVC_TASK_STATS:
             registers->r0 = sched_service_call(svc_number, registers->r0,
                                                registers->r1);
             break;
@@ -62,6 +70,41 @@ void __attribute__((section(".kernel"))) svc_handler(struct stacked_registers *r
         case SVC_RELEASE:
             registers->r0 = mutex_service_call(svc_number, registers->r0);
             break;
+        case SVC_SEM_WAIT:
+        case SVC_SEM_POST:
+            registers->r0 = semaphore_service_call(svc_number, registers->r0,
+                                                   registers->r1);
+            break;
+        case SVC_EVENT_WAIT:
+        case SVC_EVENT_SET:
+            registers->r0 = event_service_call(svc_number, registers->r0,
+                                               registers->r1);
+            break;
+        case SVC_MSG_QUEUE_SEND:
+        case SVC_MSG_QUEUE_RECEIVE:
+            registers->r0 = msg_queue_service_call(svc_number, registers->r0,
+                                                   registers->r1);
+            break;
+        case SVC_RWLOCK_READ_ACQUIRE:
+        case SVC_RWLOCK_READ_RELEASE:
+        case SVC_RWLOCK_WRITE_ACQUIRE:
+        case SVC_RWLOCK_WRITE_RELEASE:
+            registers->r0 = rwlock_service_call(svc_number, registers->r0);
+            break;
+#ifdef CONFIG_HRTIMER
+        case SVC_HRTIMER_START:
+        case SVC_HRTIMER_CANCEL:
+            registers->r0 = hrtimer_service_call(svc_number, registers->r0,
+                                                 registers->r1);
+            break;
+#endif
+#ifdef CONFIG_TASKLETS
+        case SVC_TASKLET_START:
+        case SVC_TASKLET_STOP:
+            registers->r0 = tasklet_service_call(svc_number, registers->r0,
+                                                 registers->r1);
+            break;
+#endif
         default:
             panic_print("Unknown SVC: %d", svc_number);
             break;
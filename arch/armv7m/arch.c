@@ -21,6 +21,7 @@
  */
 
 #include <arch/chip.h>
+#include <arch/mpu.h>
 #include <arch/system.h>
 #include <dev/hw/systick.h>
 #include <kernel/sched.h>
@@ -37,16 +38,37 @@ void init_arch(void) {
     /* Enable Bus and Usage Faults */
     *SCB_SHCSR |= SCB_SHCSR_BUSFAULTENA | SCB_SHCSR_USEFAULTENA;
 
+    /*
+     * PendSV performs task switches, so give it the lowest priority.
+     * All other exceptions and interrupts keep priority 0, so they never
+     * preempt each other.
+     */
+    *SCB_SHPR3 |= SCB_SHPR3_PENDSV(0xff);
+
+#ifdef CONFIG_SCHED_TRACE
+    /* Scheduler trace timestamps come from the DWT cycle counter */
+    *DEBUG_DEMCR |= DEBUG_DEMCR_TRCENA;
+    *DWT_CYCCNT = 0;
+    *DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+
+#ifdef CONFIG_MPU_STACK_GUARD
+    /* Task stacks are guarded by the MPU */
+    init_mpu();
+#endif
+
 #ifdef CONFIG_HAVE_FPU
     /* Enable the FPU */
     *SCB_CPACR |= SCB_CPACR_CP10_FULL | SCB_CPACR_CP11_FULL;
 
-    /* Enable floating point extension, and thus state preservation */
-    asm volatile ("mrs  r0, control \t\n"
-                  "orr  r0, %[fpca] \t\n"
-                  "msr  control, r0 \t\n"
-                  :: [fpca] "I" (CONTROL_FPCA)
-                  : "r0");
+    /*
+     * Enable automatic and lazy FPU state preservation.
+     *
+     * CONTROL.FPCA is set by hardware when a task first uses the FPU, so
+     * only those tasks have an extended exception frame, and the space
+     * for s0-s15 is only written if the exception handler uses the FPU.
+     */
+    *FPU_CCR |= FPU_CCR_ASPEN | FPU_CCR_LSPEN;
 #endif
 }
 
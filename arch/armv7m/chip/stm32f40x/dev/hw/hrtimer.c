@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <arch/system.h>
+#include <arch/chip/registers.h>
+#include <arch/chip/timer.h>
+#include <dev/raw_mem.h>
+#include <kernel/hrtimer.h>
+#include <kernel/init.h>
+#include <kernel/trace.h>
+
+/*
+ * High resolution timer interrupt, from TIM2 compare channel 1.
+ *
+ * TIM2 already counts freely over its full 32-bit range for the
+ * perfcounter, so the compare is simply set the delay ahead of the current
+ * count.  This leaves the other timers free for PWM.
+ */
+
+/* Timers on APB1 are clocked at system clock / 2 */
+#define TIMER_MHZ       (CONFIG_SYS_CLOCK / 2 / 1000000)
+
+/*
+ * Minimum counts ahead of the current count to program the compare, so it
+ * isn't missed while it is being written.
+ */
+#define MIN_COUNTS      (16)
+
+void hrtimer_handler(void) {
+    struct stm32f4_timer_regs *regs = timer_get_regs(2);
+
+    trace_record(TRACE_ISR_ENTER, IPSR());
+
+    /* Flags are cleared by writing zero, others are unaffected by ones */
+    raw_mem_write(&regs->SR, ~TIM_SR_CC1IF);
+
+    hrtimer_interrupt();
+
+    trace_record(TRACE_ISR_EXIT, IPSR());
+}
+
+void arch_hrtimer_program(uint32_t delay_ns) {
+    struct stm32f4_timer_regs *regs = timer_get_regs(2);
+    uint32_t counts;
+
+    /* Avoid overflowing 32 bits for long delays */
+    counts = (delay_ns / 1000) * TIMER_MHZ
+             + ((delay_ns % 1000) * TIMER_MHZ) / 1000;
+
+    if (counts < MIN_COUNTS) {
+        counts = MIN_COUNTS;
+    }
+
+    raw_mem_write(&regs->CCR1, raw_mem_read(&regs->CNT) + counts);
+    raw_mem_write(&regs->SR, ~TIM_SR_CC1IF);
+    raw_mem_set_bits(&regs->DIER, TIM_DIER_CC1IE);
+
+    /*
+     * If the count passed the compare while it was being programmed,
+     * the match was missed (or its flag cleared above), so generate it.
+     */
+    if ((int32_t) (raw_mem_read(&regs->CCR1) - raw_mem_read(&regs->CNT)) <= 0) {
+        raw_mem_write(&regs->EGR, TIM_EGR_CC1G);
+    }
+}
+
+void arch_hrtimer_stop(void) {
+    struct stm32f4_timer_regs *regs = timer_get_regs(2);
+
+    raw_mem_clear_bits(&regs->DIER, TIM_DIER_CC1IE);
+    raw_mem_write(&regs->SR, ~TIM_SR_CC1IF);
+}
+
+/* TIM2 is enabled by init_perfcounter(), before core initializers */
+static int stm32f4_hrtimer_init(void) {
+    *NVIC_ISER0 |= (1 << 28);   /* Enable TIM2 interrupt */
+
+    return 0;
+}
+CORE_INITIALIZER(stm32f4_hrtimer_init)
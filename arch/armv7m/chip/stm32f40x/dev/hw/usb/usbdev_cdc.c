@@ -33,19 +33,16 @@ static void std_setup_packet(struct usbdev_setup_packet *setup);
 static void cdc_setup_packet(struct usbdev_setup_packet *setup);
 static void cdc_set_configuration(uint16_t configuration);
 
-void usbdev_setup(struct ring_buffer *packet, uint32_t len) {
+void usbdev_setup(struct ring *packet, uint32_t len) {
     uint8_t buf[8];
-    for (int i = 0; i < 8; i++) {
-        if (ring_buf_empty(packet)) {
-            break;
-        }
-        buf[i] = packet->buf[packet->start];
-        packet->start = (packet->start + 1) % packet->len;
-    }
+
+    /* A newer SETUP packet supersedes any still waiting to be handled */
+    do {
+        ring_read(packet, buf, sizeof(buf));
+    } while (ring_used(packet) >= sizeof(buf));
 
     /* Clear ring buffer */
-    packet->start = 0;
-    packet->end = 0;
+    ring_discard(packet);
 
     struct usbdev_setup_packet *setup = (struct usbdev_setup_packet *) buf;
 
@@ -85,13 +82,17 @@ static void std_setup_packet(struct usbdev_setup_packet *setup) {
         break;
     case USB_SETUP_REQUEST_SET_ADDRESS:
         DEBUG_PRINT("SET_ADDRESS %d ", setup->value);
+        usbdev_int_mask();
         *USB_FS_DCFG |= USB_FS_DCFG_DAD(setup->value);
         usbdev_status_in_packet();
+        usbdev_int_unmask();
         break;
     case USB_SETUP_REQUEST_SET_CONFIGURATION:
         DEBUG_PRINT("SET_CONFIGURATION %d ", setup->value);
+        usbdev_int_mask();
         cdc_set_configuration(setup->value);
         usbdev_status_in_packet();
+        usbdev_int_unmask();
         break;
     case USB_SETUP_REQUEST_GET_STATUS:
         DEBUG_PRINT("GET_STATUS ");
@@ -113,11 +114,15 @@ static void cdc_setup_packet(struct usbdev_setup_packet *setup) {
     switch (setup->request) {
     case USB_SETUP_REQUEST_CDC_SET_CONTROL_LINE_STATE:
         DEBUG_PRINT("CDC: SET_CONTROL_LINE_STATE Warning: Not handled ");
+        usbdev_int_mask();
         usbdev_status_in_packet();
+        usbdev_int_unmask();
         break;
     case USB_SETUP_REQUEST_CDC_SET_LINE_CODING:
         DEBUG_PRINT("CDC: SET_LINE_CODING Warning: Not handled ");
+        usbdev_int_mask();
         usbdev_status_in_packet();
+        usbdev_int_unmask();
         break;
     default:
         DEBUG_PRINT("CDC: OTHER_REQUEST %d ", setup->request);
@@ -153,22 +158,13 @@ static void cdc_set_configuration(uint16_t configuration) {
     endpoints[USB_CDC_TX_ENDPOINT] = &ep_tx;
 
     if (endpoints[1]) {
-        endpoints[1]->tx.buf = ep_tx_buf[1];
-        endpoints[1]->tx.len = 4*USB_TX1_FIFO_SIZE;
-        endpoints[1]->tx.start = 0;
-        endpoints[1]->tx.end = 0;
+        init_ring(&endpoints[1]->tx, ep_tx_buf[1], 4*USB_TX1_FIFO_SIZE);
     }
     if (endpoints[2]) {
-        endpoints[2]->tx.buf = ep_tx_buf[2];
-        endpoints[2]->tx.len = 4*USB_TX2_FIFO_SIZE;
-        endpoints[2]->tx.start = 0;
-        endpoints[2]->tx.end = 0;
+        init_ring(&endpoints[2]->tx, ep_tx_buf[2], 4*USB_TX2_FIFO_SIZE);
     }
     if (endpoints[3]) {
-        endpoints[3]->tx.buf = ep_tx_buf[3];
-        endpoints[3]->tx.len = 4*USB_TX3_FIFO_SIZE;
-        endpoints[3]->tx.start = 0;
-        endpoints[3]->tx.end = 0;
+        init_ring(&endpoints[3]->tx, ep_tx_buf[3], 4*USB_TX3_FIFO_SIZE);
     }
 
     usb_ready = 1;
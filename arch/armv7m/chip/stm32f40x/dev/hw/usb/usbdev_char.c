@@ -67,15 +67,7 @@ static int usb_read(struct char_device *dev, char *buf, size_t num) {
 
     acquire(&usb->read_mutex);
 
-    for (int i = 0; i < num; i++) {
-        if (ring_buf_empty(&ep_rx.rx)) {
-            break;
-        }
-
-        buf[i] = (char) ep_rx.rx.buf[ep_rx.rx.start];
-        ep_rx.rx.start = (ep_rx.rx.start + 1) % ep_rx.rx.len;
-        total++;
-    }
+    total = ring_read(&ep_rx.rx, buf, num);
 
     release(&usb->read_mutex);
 
@@ -23,6 +23,6 @@
 #ifndef DEV_HW_USB_USBDEV_CLASS_H_INCLUDED
 #define DEV_HW_USB_USBDEV_CLASS_H_INCLUDED
 
-void usbdev_setup(struct ring_buffer *ring, uint32_t len);
+void usbdev_setup(struct ring *ring, uint32_t len);
 
 #endif
@@ -53,7 +53,7 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
     }
 
     /* Wait until current buffer is empty */
-    while (!ring_buf_empty(&ep->tx)) {
+    while (!ring_empty(&ep->tx)) {
         yield_if_possible();
     }
 
@@ -61,15 +61,13 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
     int written = 0;
 
     /* Copy to ring buffer */
-    while (size > 0 && !ring_buf_full(&ep->tx)) {
-        ep->tx.buf[ep->tx.end] = *packet++;
-        size--;
-        written++;
-
-        ep->tx.end = (ep->tx.end + 1) % ep->tx.len;
+    if (size > 0) {
+        written = ring_write(&ep->tx, packet, size);
+        packet += written;
+        size -= written;
     }
 
-    if (ring_buf_full(&ep->tx)) {
+    if (ring_full(&ep->tx)) {
         filled_buffer = 1;
     }
 
@@ -79,6 +77,10 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
     }
 
     int count = 500;
+
+    /* Keep the interrupt handler off the endpoint while it is programmed */
+    usbdev_int_mask();
+
     /* Setup endpoint for transmit */
     if (ep->num == 0) {
         /* Wait for ep to disable */
@@ -93,8 +95,10 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
             *USB_FS_DIEPCTL0 |= USB_FS_DIEPCTL0_SNAK;
             *USB_FS_DIEPMSK |= USB_FS_DIEPMSK_INEPNEM | USB_FS_DIEPMSK_EPDM;
 
-            /* Wait for endpoint to disable */
+            /* Wait for the interrupt handler to disable the endpoint */
+            usbdev_int_unmask();
             while(ep->request_disable);
+            usbdev_int_mask();
 
             *USB_FS_DIEPMSK &= ~(USB_FS_DIEPMSK_INEPNEM | USB_FS_DIEPMSK_EPDM);
         }
@@ -115,8 +119,10 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
             *USB_FS_DIEPCTL(ep->num) |= USB_FS_DIEPCTLx_SNAK;
             *USB_FS_DIEPMSK |= USB_FS_DIEPMSK_INEPNEM | USB_FS_DIEPMSK_EPDM;
 
-            /* Wait for endpoint to disable */
+            /* Wait for the interrupt handler to disable the endpoint */
+            usbdev_int_unmask();
             while(ep->request_disable);
+            usbdev_int_mask();
 
             *USB_FS_DIEPMSK &= ~(USB_FS_DIEPMSK_INEPNEM | USB_FS_DIEPMSK_EPDM);
         }
@@ -128,6 +134,8 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
     /* Enable TX FIFO empty interrupt */
     *USB_FS_DIEPEMPMSK |= (1 << ep->num);
 
+    usbdev_int_unmask();
+
     /* Filled buffer, call recursively until packet finishes */
     if (filled_buffer && size) {
         int ret = usbdev_write(ep, packet, size);
@@ -142,7 +150,7 @@ int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size) {
     return written;
 }
 
-void usbdev_fifo_read(volatile struct ring_buffer *ring, int size) {
+void usbdev_fifo_read(struct ring *ring, int size) {
     int words = (size+3)/4;
 
     /* Allow us to read into NULL */
@@ -163,21 +171,14 @@ void usbdev_fifo_read(volatile struct ring_buffer *ring, int size) {
             data.uint32 = *USB_FS_DFIFO_EP(0);
             words--;
 
-            for (int i = 0; i < 4; i++) {
-                if (size <= 0) {
-                    data.uint8[i] = 0;
-                    continue;
-                }
+            int bytes = size < 4 ? size : 4;
 
-                ring->buf[ring->end] = data.uint8[i];
-                size--;
-
-                if (ring_buf_full(ring)) {
-                    DEBUG_PRINT("Warning: USB: Buffer full.\r\n");
-                    ring->start = (ring->start + 1) % ring->len;
-                }
-                ring->end = (ring->end + 1) % ring->len;
+            /* Only the reader may advance the tail, so drop new data when full */
+            if (ring_write(ring, data.uint8, bytes) < bytes) {
+                DEBUG_PRINT("Warning: USB: Buffer full.\r\n");
             }
+
+            size -= bytes;
         }
     }
 }
@@ -209,19 +210,11 @@ void usbdev_data_in(struct endpoint *ep) {
     /* Write until buffer empty */
     int written = 0;
     int space = *USB_FS_DTXFSTS(ep->num);
-    while (written < space && !ring_buf_empty(&ep->tx)) {
+    while (written < space && !ring_empty(&ep->tx)) {
         union uint8_uint32 data;
         data.uint32 = 0;
 
-        for (int i = 0; i < 4; i++) {
-            if (!ring_buf_empty(&ep->tx)) {
-                data.uint8[i] = ep->tx.buf[ep->tx.start];
-                ep->tx.start = (ep->tx.start + 1) % ep->tx.len;
-            }
-            else {
-                data.uint8[i] = 0;
-            }
-        }
+        ring_read(&ep->tx, data.uint8, 4);
 
         DEBUG_PRINT("0x%x ", data.uint32);
 
@@ -230,7 +223,7 @@ void usbdev_data_in(struct endpoint *ep) {
     }
 
     /* Only disable interrupt once all data has been written */
-    if (ring_buf_empty(&ep->tx)) {
+    if (ring_empty(&ep->tx)) {
         *USB_FS_DIEPEMPMSK &= ~(1 << ep->num);
     }
 }
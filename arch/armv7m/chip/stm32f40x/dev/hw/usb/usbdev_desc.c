@@ -35,18 +35,8 @@ struct endpoint ep_ctl = {
     .num = 0,
     .dir = USB_DIR_IN,
     .mpsize = 64,
-    .rx = {
-        .buf = ep_ctl_rx_buf,
-        .len = 4*USB_RX_FIFO_SIZE,
-        .start = 0,
-        .end = 0
-    },
-    .tx = {
-        .buf = NULL,
-        .len = 0,
-        .start = 0,
-        .end = 0
-    },
+    .rx = INIT_RING(ep_ctl_rx_buf, 4*USB_RX_FIFO_SIZE),
+    .tx = INIT_RING(NULL, 0),
     .request_disable = 0
 };
 
@@ -54,18 +44,8 @@ struct endpoint ep_acm = {
     .num = USB_CDC_ACM_ENDPOINT,
     .dir = USB_DIR_OUT,
     .mpsize = USB_CDC_ACM_MPSIZE,
-    .rx = {
-        .buf = NULL,
-        .len = 0,
-        .start = 0,
-        .end = 0
-    },
-    .tx = {
-        .buf = NULL,
-        .len = 0,
-        .start = 0,
-        .end = 0
-    },
+    .rx = INIT_RING(NULL, 0),
+    .tx = INIT_RING(NULL, 0),
     .request_disable = 0
 };
 
@@ -75,18 +55,8 @@ struct endpoint ep_rx = {
     .num = USB_CDC_RX_ENDPOINT,
     .dir = USB_DIR_IN,
     .mpsize = USB_CDC_RX_MPSIZE,
-    .rx = {
-        .buf = ep_rx_buf,
-        .len = 4*USB_RX_FIFO_SIZE,
-        .start = 0,
-        .end = 0
-    },
-    .tx = {
-        .buf = NULL,
-        .len = 0,
-        .start = 0,
-        .end = 0
-    },
+    .rx = INIT_RING(ep_rx_buf, 4*USB_RX_FIFO_SIZE),
+    .tx = INIT_RING(NULL, 0),
     .request_disable = 0
 };
 
@@ -94,18 +64,8 @@ struct endpoint ep_tx = {
     .num = USB_CDC_TX_ENDPOINT,
     .dir = USB_DIR_OUT,
     .mpsize = USB_CDC_TX_MPSIZE,
-    .rx = {
-        .buf = NULL,
-        .len = 0,
-        .start = 0,
-        .end = 0
-    },
-    .tx = {
-        .buf = NULL,
-        .len = 0,
-        .start = 0,
-        .end = 0
-    },
+    .rx = INIT_RING(NULL, 0),
+    .tx = INIT_RING(NULL, 0),
     .request_disable = 0
 };
 
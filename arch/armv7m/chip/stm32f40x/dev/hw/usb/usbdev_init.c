@@ -37,7 +37,7 @@ static inline void usbdev_clocks_init(void);
 int init_usbdev(void) {
     usbdev_clocks_init();
 
-    ep_tx_buf[0] = malloc(4*USB_TX0_FIFO_SIZE + 1);
+    ep_tx_buf[0] = malloc(4*USB_TX0_FIFO_SIZE);
     ep_tx_buf[1] = malloc(4*USB_TX1_FIFO_SIZE);
     ep_tx_buf[2] = malloc(4*USB_TX2_FIFO_SIZE);
     ep_tx_buf[3] = malloc(4*USB_TX3_FIFO_SIZE);
@@ -47,10 +47,7 @@ int init_usbdev(void) {
         }
     }
 
-    ep_ctl.tx.buf = ep_tx_buf[0];
-    ep_ctl.tx.len = 4*USB_TX0_FIFO_SIZE + 1;
-    ep_ctl.tx.start = 0;
-    ep_ctl.tx.end = 0;
+    init_ring(&ep_ctl.tx, ep_tx_buf[0], 4*USB_TX0_FIFO_SIZE);
 
     /* Global unmask of USB interrupts, TX empty interrupt when TX is actually empty */
     *USB_FS_GAHBCFG |= USB_FS_GAHBCFG_GINTMSK;
@@ -78,7 +75,7 @@ CORE_INITIALIZER(init_usbdev)
 static inline void usbdev_clocks_init(void) {
     *RCC_AHB2ENR |= RCC_AHB2ENR_OTGFSEN;    /* Enable USB OTG FS clock */
     *RCC_AHB1ENR |= RCC_AHB1ENR_GPIOAEN;    /* Enable GPIOA Clock */
-    *NVIC_ISER2 |= (1 << 3);                /* Unable USB FS Interrupt */
+    *NVIC_ISER2 |= USBDEV_NVIC_BIT;         /* Unable USB FS Interrupt */
 
     /* Set PA9, PA10, PA11, and PA12 to alternative function OTG
      * See stm32f4_ref.pdf pg 141 and stm32f407.pdf pg 51 */
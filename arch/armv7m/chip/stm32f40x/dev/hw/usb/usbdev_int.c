@@ -21,8 +21,11 @@
  */
 
 #include <stddef.h>
+#include <arch/system.h>
 #include <arch/chip/registers.h>
 #include <kernel/fault.h>
+#include <kernel/trace.h>
+#include <kernel/workqueue.h>
 
 #include "usbdev_internals.h"
 #include "usbdev_desc.h"
@@ -30,14 +33,19 @@
 #include <dev/hw/usbdev.h>
 
 /* Setup packet buffer */
-uint8_t setup_buf[3*4];
+DEFINE_RING(setup_packet, 16);
 
-struct ring_buffer setup_packet = {
-    .buf = setup_buf,
-    .len = sizeof(setup_buf)/sizeof(setup_buf[0]),
-    .start = 0,
-    .end = 0
-};
+/*
+ * SETUP packets are answered from the worker task, since replying may wait
+ * on the endpoint.  The host retries the data stage until then.  The worker
+ * masks this interrupt while it programs endpoint registers, see
+ * usbdev_int_mask().
+ */
+static void setup_work_func(struct work *work) {
+    usbdev_setup(&setup_packet, 4);
+}
+
+static struct work setup_work = INIT_WORK(setup_work_func);
 
 /* Global interrupt handlers */
 static void gint_mmis(void);
@@ -100,12 +108,16 @@ void (*usbdev_gint_handler[32])(void) = {
 void usbdev_handler(void) {
     uint32_t interrupts = *USB_FS_GINTSTS;
 
+    trace_record(TRACE_ISR_ENTER, IPSR());
+
     /* Loop through all bits except bit 0, which isn't an interrupt */
     for (int i = 1; i < 32; i++) {
         if (interrupts & (1 << i) && usbdev_gint_handler[i]) {
             usbdev_gint_handler[i]();
         }
     }
+
+    trace_record(TRACE_ISR_EXIT, IPSR());
 }
 
 static void gint_mmis(void) {
@@ -343,7 +355,7 @@ static void gint_oepint(void) {
         if (interrupts & USB_FS_DOEPINTx_STUP) {
             *USB_FS_DOEPINT(i) = USB_FS_DOEPINTx_STUP;
             DEBUG_PRINT("SETUP phase done. ");
-            usbdev_setup(&setup_packet, 4);
+            queue_work(&setup_work);
         }
         if (interrupts & USB_FS_DOEPINTx_OTEPDIS) {
             *USB_FS_DOEPINT(i) = USB_FS_DOEPINTx_OTEPDIS;
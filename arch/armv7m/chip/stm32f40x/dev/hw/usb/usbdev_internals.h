@@ -23,6 +23,9 @@
 #ifndef USBDEV_INTERNALS_H_INCLUDED
 #define USBDEV_INTERNALS_H_INCLUDED
 
+#include <ring.h>
+#include <arch/system.h>
+
 #define     USB_VERSION_1_1                                 (0x110)
 #define     USB_CLASS_CDC                                   (0x02)
 #define     USB_CLASS_CDC_DATA                              (0x0A)
@@ -203,49 +206,45 @@ struct __attribute__((packed)) usb_cdc_acm_union_functional_descriptor {
     uint8_t     bSlaveInterface0;
 };
 
-/* Ring buffer semantics always leave one space empty.
- * If start == end, buffer is empty */
-struct ring_buffer {
-    volatile uint8_t    *buf;
-    volatile int        len;
-    volatile int        start;
-    volatile int        end;
-};
-
 struct endpoint {
     uint8_t             num;
     uint8_t             dir;
     uint16_t            mpsize;
-    volatile struct ring_buffer  rx;
-    volatile struct ring_buffer  tx;
+    struct ring         rx;
+    struct ring         tx;
     volatile uint8_t    request_disable;
 };
 
+/* USB OTG FS global interrupt enable, in NVIC_ISER2/NVIC_ICER2 */
+#define USBDEV_NVIC_BIT     (1 << 3)
+
+/*
+ * Mask the USB interrupt
+ *
+ * SETUP packets are answered from the worker task, which programs the same
+ * endpoint registers as the interrupt handler.  Task context code masks the
+ * interrupt around each sequence of endpoint register writes, so the
+ * handler never runs in the middle of one.  The interrupt must be unmasked
+ * while waiting on the handler.
+ */
+static inline void usbdev_int_mask(void) {
+    *NVIC_ICER2 = USBDEV_NVIC_BIT;
+
+    /* The handler must not run after the mask returns */
+    DSB();
+    ISB();
+}
+
+static inline void usbdev_int_unmask(void) {
+    *NVIC_ISER2 = USBDEV_NVIC_BIT;
+}
+
 void usbdev_reset(void);
 int usbdev_write(struct endpoint *ep, const uint8_t *packet, int size);
-void usbdev_fifo_read(volatile struct ring_buffer *ring, int size);
+void usbdev_fifo_read(struct ring *ring, int size);
 void usbdev_data_out(uint32_t status);
 void usbdev_data_in(struct endpoint *ep);
 void usbdev_status_in_packet(void);
 void usbdev_enable_receive(struct endpoint *ep);
 
-inline static int ring_buf_full(volatile struct ring_buffer *ring);
-inline static int ring_buf_full(volatile struct ring_buffer *ring) {
-    if (ring->start - ring->end == 1) {
-        return 1;
-    }
-    if (ring->start == 0 && ring->end == (ring->len-1)) {
-        return 1;
-    }
-    return 0;
-}
-
-inline static int ring_buf_empty(volatile struct ring_buffer *ring);
-inline static int ring_buf_empty(volatile struct ring_buffer *ring) {
-    if (ring->start == ring->end) {
-        return 1;
-    }
-    return 0;
-}
-
 #endif
@@ -141,6 +141,17 @@ static inline struct stm32f4_timer_regs *timer_get_regs(int num) {
 #define TIM_DIER_CC4DE      ((uint32_t) (1 << 12))  /* TIM CC4 DMA request enable */
 #define TIM_DIER_TDE        ((uint32_t) (1 << 14))  /* TIM trigger DMA request enable */
 
+#define TIM_SR_UIF          ((uint32_t) (1 << 0))   /* TIM update interrupt flag */
+#define TIM_SR_CC1IF        ((uint32_t) (1 << 1))   /* TIM CC1 interrupt flag */
+#define TIM_SR_CC2IF        ((uint32_t) (1 << 2))   /* TIM CC2 interrupt flag */
+#define TIM_SR_CC3IF        ((uint32_t) (1 << 3))   /* TIM CC3 interrupt flag */
+#define TIM_SR_CC4IF        ((uint32_t) (1 << 4))   /* TIM CC4 interrupt flag */
+#define TIM_SR_TIF          ((uint32_t) (1 << 6))   /* TIM trigger interrupt flag */
+#define TIM_SR_CC1OF        ((uint32_t) (1 << 9))   /* TIM CC1 overcapture flag */
+#define TIM_SR_CC2OF        ((uint32_t) (1 << 10))  /* TIM CC2 overcapture flag */
+#define TIM_SR_CC3OF        ((uint32_t) (1 << 11))  /* TIM CC3 overcapture flag */
+#define TIM_SR_CC4OF        ((uint32_t) (1 << 12))  /* TIM CC4 overcapture flag */
+
 #define TIM_EGR_UG          ((uint32_t) (1 << 0))   /* TIM Update generation */
 #define TIM_EGR_CC1G        ((uint32_t) (1 << 1))   /* TIM Capture/Compare 1 generation */
 #define TIM_EGR_CC2G        ((uint32_t) (1 << 2))   /* TIM Capture/Compare 2 generation */
@@ -21,6 +21,7 @@
  */
 
 #include <stdint.h>
+#include <arch/mpu.h>
 #include <arch/system.h>
 #include <dev/hw/led.h>
 #include <kernel/sched.h>
@@ -111,6 +112,13 @@ void memmanage_handler(void) {
     uint8_t status;
     uint8_t interpretation = 0;
 
+#ifdef CONFIG_MPU_STACK_GUARD
+    /* Expected fault, probing protected memory */
+    if (mpu_probe_fault()) {
+        return;
+    }
+#endif
+
     status = (uint8_t) (*SCB_CFSR & 0xff);
 
     fatal_fault_entry();
@@ -150,6 +158,14 @@ void memmanage_handler(void) {
         printk("Fault occurred during floating-point lazy state preservation.\r\n");
     }
 
+#ifdef CONFIG_MPU_STACK_GUARD
+    if ((status & SCB_MMFSR_MSTKERR) ||
+        ((status & SCB_MMFSR_MMARVALID) && mpu_stack_guard_hit(*SCB_MMFAR))) {
+        printk("This is most likely an overflow of the stack of the current task"
+             " (0x%x) into its guard region.\r\n", curr_task);
+    }
+#endif
+
     if (!interpretation) {
         printk("No idea.  See pg. 225 in the STM32F4 Programming Reference Manual.\r\n");
     }
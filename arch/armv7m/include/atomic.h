@@ -213,4 +213,17 @@ static __always_inline uint8_t store_conditional16(volatile uint16_t *address,
     return failed;
 }
 
+/* A full data memory barrier serves for loads and stores alike */
+static __always_inline void smp_mb(void) {
+    asm volatile ("dmb" ::: "memory");
+}
+
+static __always_inline void smp_rmb(void) {
+    smp_mb();
+}
+
+static __always_inline void smp_wmb(void) {
+    smp_mb();
+}
+
 #endif /* ARCH_ATOMIC_H_INCLUDED */
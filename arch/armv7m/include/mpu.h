@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef ARCH_MPU_H_INCLUDED
+#define ARCH_MPU_H_INCLUDED
+
+#include <stdint.h>
+
+/**
+ * Enable the MPU
+ *
+ * The MPU is enabled with the default memory map as a background region for
+ * privileged accesses, so only explicitly protected regions are affected.
+ * Memory management faults are enabled, so violations fault immediately.
+ */
+void init_mpu(void) __attribute__((section(".kernel")));
+
+/**
+ * Check if an address is in the current stack guard region
+ *
+ * @param addr  Faulting address
+ * @returns 1 if addr is in the guard region of the current task's stack,
+ *          0 otherwise
+ */
+int mpu_stack_guard_hit(uintptr_t addr) __attribute__((section(".kernel")));
+
+/**
+ * Check if reading an address causes a memory management fault
+ *
+ * The fault is caught, rather than bringing down the system, so this can
+ * be used to test that memory is protected.  Must be called from a task.
+ *
+ * @param addr  Address to read
+ * @returns 1 if the read faulted, 0 otherwise
+ */
+int mpu_probe(volatile uint32_t *addr);
+
+/**
+ * Handle a memory management fault caused by mpu_probe()
+ *
+ * Called by the memory management fault handler.  If mpu_probe() is
+ * reading, skips the faulting read and records the fault.
+ *
+ * @returns 1 if the fault was caused, and handled, by mpu_probe(), 0
+ *          otherwise
+ */
+int mpu_probe_fault(void) __attribute__((section(".kernel")));
+
+#endif
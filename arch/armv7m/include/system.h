@@ -81,6 +81,16 @@ static __always_inline uint32_t *MSP(void) {
     return val;
 }
 
+/* Complete all outstanding memory accesses, including to system registers */
+static __always_inline void DSB(void) {
+    asm volatile ("dsb" ::: "memory");
+}
+
+/* Flush the pipeline, so following instructions see prior system changes */
+static __always_inline void ISB(void) {
+    asm volatile ("isb" ::: "memory");
+}
+
 /* Cortex M4 General Registers */
 
 /* System Control Map */
@@ -90,6 +100,7 @@ static __always_inline uint32_t *MSP(void) {
 #define SCB_BASE                        (SCS_BASE + 0x0D00)                                     /* System Control Block Base Address */
 #define MPU_BASE                        (SCB_BASE + 0x0090)                                     /* MPU Block Base Address */
 #define FPU_BASE                        (SCB_BASE + 0x0230)                                     /* FPU Block Base Address */
+#define DWT_BASE                        (uint32_t) (0xE0001000)                                 /* Data Watchpoint and Trace Base Address */
 
 /* SysTick Timer */
 #define SYSTICK_CTL                     (volatile uint32_t *) (SYSTICK_BASE)                    /* Control register for SysTick timer peripheral */
@@ -115,6 +126,7 @@ static __always_inline uint32_t *MSP(void) {
 #define SCB_ICSR                        (volatile uint32_t *) (SCB_BASE + 0x004)                /* Interrupt Control and State Register */
 #define SCB_VTOR                        (volatile uint32_t *) (SCB_BASE + 0x008)                /* Vector Table Offset Register */
 #define SCB_SCR                         (volatile uint32_t *) (SCB_BASE + 0x010)                /* System Control Register */
+#define SCB_SHPR3                       (volatile uint32_t *) (SCB_BASE + 0x020)                /* System Handler Priority Register 3 - PendSV and SysTick */
 #define SCB_SHCSR                       (volatile uint32_t *) (SCB_BASE + 0x024)                /* System Handler Control and State Register */
 #define SCB_CFSR                        (volatile uint32_t *) (SCB_BASE + 0x028)                /* Configurable fault status register - Describes Usage, Bus, and Memory faults */
 #define SCB_HFSR                        (volatile uint32_t *) (SCB_BASE + 0x02C)                /* Hard fault status register - Describes hard fault */
@@ -130,6 +142,14 @@ static __always_inline uint32_t *MSP(void) {
 #define MPU_RBAR                        (volatile uint32_t *) (MPU_BASE + 0x0C)                 /* MPU Region Base Address Register */
 #define MPU_RASR                        (volatile uint32_t *) (MPU_BASE + 0x10)                 /* MPU Region Attribute and Size Register */
 
+/* Debug Exception and Monitor Control */
+#define DEBUG_DEMCR                     (volatile uint32_t *) (SCS_BASE + 0x0DFC)               /* Debug Exception and Monitor Control Register */
+
+/* Data Watchpoint and Trace (DWT)
+ * ARM DDI 0403 (ARMv7-M Architecture Reference Manual) */
+#define DWT_CTRL                        (volatile uint32_t *) (DWT_BASE + 0x00)                 /* DWT Control Register */
+#define DWT_CYCCNT                      (volatile uint32_t *) (DWT_BASE + 0x04)                 /* DWT Cycle Count Register */
+
 /* Floating Point Unit (FPU)
  * ST PM0214 (Cortex M4 Programming Manual) pg. 236 */
 #define FPU_CCR                         (volatile uint32_t *) (FPU_BASE + 0x04)                 /* FPU Context Control Register */
@@ -142,7 +162,20 @@ static __always_inline uint32_t *MSP(void) {
 #define CONTROL_SPSEL                   (1 << 1)                                                /* SP selection */
 #define CONTROL_FPCA                    (1 << 2)                                                /* FP extension enable */
 
+/* SysTick Timer */
+#define SYSTICK_CTL_ENABLE              (uint32_t) (1 << 0)                                     /* Enable counter */
+#define SYSTICK_CTL_TICKINT             (uint32_t) (1 << 1)                                     /* Exception request on count to 0 */
+#define SYSTICK_CTL_CLKSOURCE           (uint32_t) (1 << 2)                                     /* Use processor clock */
+#define SYSTICK_CTL_COUNTFLAG           (uint32_t) (1 << 16)                                    /* Count reached 0 since last read */
+#define SYSTICK_RELOAD_MAX              (uint32_t) (0x00FFFFFF)                                 /* Maximum reload value (24-bit) */
+
+/* Exception return values */
+#define EXC_RETURN_THREAD_PSP           (uint32_t) (0xFFFFFFFD)                                 /* Return to thread mode, using PSP, basic frame */
+#define EXC_RETURN_FTYPE                (uint32_t) (1 << 4)                                     /* Clear if extended (FPU) frame stacked */
+
 /* System Control Block */
+#define SCB_ICSR_PENDSTCLR              (uint32_t) (1 << 25)                                    /* Clear SysTick interrupt */
+#define SCB_ICSR_PENDSTSET              (uint32_t) (1 << 26)                                    /* Set SysTick interrupt */
 #define SCB_ICSR_PENDSVCLR              (uint32_t) (1 << 27)                                    /* Clear PendSV interrupt */
 #define SCB_ICSR_PENDSVSET              (uint32_t) (1 << 28)                                    /* Set PendSV interrupt */
 
@@ -150,6 +183,9 @@ static __always_inline uint32_t *MSP(void) {
 #define SCB_SCR_SLEEPDEEP               (uint32_t) (1 << 2)                                     /* Use deep sleep as low power mode */
 #define SCB_SCR_SEVONPEND               (uint32_t) (1 << 4)                                     /* Send event on pending exception */
 
+#define SCB_SHPR3_PENDSV(n)             (uint32_t) ((n) << 16)                                  /* PendSV priority */
+#define SCB_SHPR3_SYSTICK(n)            (uint32_t) ((n) << 24)                                  /* SysTick priority */
+
 #define SCB_SHCSR_MEMFAULTENA           (uint32_t) (1 << 16)                                    /* Enables Memory Management Fault */
 #define SCB_SHCSR_BUSFAULTENA           (uint32_t) (1 << 17)                                    /* Enables Bus Fault */
 #define SCB_SHCSR_USEFAULTENA           (uint32_t) (1 << 18)                                    /* Enables Usage Fault */
@@ -204,8 +240,15 @@ static __always_inline uint32_t *MSP(void) {
 #define MPU_RASR_AP_PRIV_RO_UN_RO       (uint32_t) (6 << 24)                                    /* All RO Permissions */
 #define MPU_RASR_XN                     (uint32_t) (1 << 28)                                    /* MPU Region Execute Never */
 
+/* Debug Exception and Monitor Control */
+#define DEBUG_DEMCR_TRCENA              (uint32_t) (1 << 24)                                    /* Enable DWT and ITM */
+
+/* Data Watchpoint and Trace (DWT) */
+#define DWT_CTRL_CYCCNTENA              (uint32_t) (1 << 0)                                     /* Enable cycle counter */
+
 /* Floating Point Unit (FPU)
  * ST PM0214 (Cortex M4 Programming Manual) pg. 236 */
 #define FPU_CCR_ASPEN                   (uint32_t) (1 << 31)                                    /* FPU Automatic State Preservation */
+#define FPU_CCR_LSPEN                   (uint32_t) (1 << 30)                                    /* FPU Lazy State Preservation */
 
 #endif
@@ -20,20 +20,79 @@
  * SOFTWARE.
  */
 
+#include <math.h>
+#include <stdint.h>
 #include <arch/system.h>
 #include <kernel/sched.h>
 #include <kernel/sched_internals.h>
+#include <kernel/trace.h>
 #include "sched.h"
 
+/* SysTick counts per system tick */
+#define SYSTICK_PERIOD  (CONFIG_SYS_CLOCK / CONFIG_SYSTICK_FREQ)
+
+/* SysTick counts per microsecond */
+#define SYSTICK_COUNTS_PER_US   (CONFIG_SYS_CLOCK / 1000000)
+
 /* System tick interrupt handler */
 void systick_handler(void) {
-    /* Call PendSV to do switching */
-    *SCB_ICSR |= SCB_ICSR_PENDSVSET;
+    trace_record(TRACE_ISR_ENTER, IPSR());
+
+    /* Any resulting switch is pended to PendSV */
+    sched_system_tick();
+
+    trace_record(TRACE_ISR_EXIT, IPSR());
 }
 
-/* PendSV interrupt handler */
+/*
+ * PendSV interrupt handler
+ *
+ * PendSV has the lowest exception priority, so it is only taken once all
+ * other handlers have returned.  Called with interrupts masked.
+ */
 void pendsv_handler(void){
-    sched_system_tick();
+    sched_pended_switch();
+}
+
+#ifdef CONFIG_SCHED_TRACE
+/* The DWT cycle counter is enabled by init_arch() */
+uint32_t arch_trace_timestamp(void) {
+    return *DWT_CYCCNT;
+}
+#endif
+
+/*
+ * SysTick counts down to the next tick.  After tickless idle, it first
+ * counts down the remainder of the current period, so the position in the
+ * period is always found from the normal period.
+ */
+uint32_t arch_sched_tick_elapsed_ns(void) {
+    uint32_t val = *SYSTICK_VAL;
+    uint32_t counts;
+
+    /*
+     * The counter wrapped, but the tick hasn't been handled yet, because
+     * this is called from a handler or with interrupts masked.  val may
+     * have been read before the wrap, so read it again.
+     */
+    if (*SCB_ICSR & SCB_ICSR_PENDSTSET) {
+        val = *SYSTICK_VAL;
+        counts = SYSTICK_PERIOD;
+    }
+    else {
+        counts = 0;
+    }
+
+    if (val < SYSTICK_PERIOD) {
+        counts += SYSTICK_PERIOD - val;
+    }
+
+    return counts * 1000 / SYSTICK_COUNTS_PER_US;
+}
+
+int arch_sched_pend_switch(void) {
+    *SCB_ICSR = SCB_ICSR_PENDSVSET;
+    return 1;
 }
 
 uint32_t *get_user_stack_pointer(void) {
@@ -50,28 +109,13 @@ void create_context(task_ctrl* task, void (*lptr)(void)) {
     stack -= stack % 8;
     task->stack_top = (uint32_t *) stack;
 
-    asm volatile(
-#ifdef CONFIG_HAVE_FPU
-                 "stmdb   %[stack]!, {%[zero]}  /* Empty for 8byte aligned SP */\n\
-                  stmdb   %[stack]!, {%[zero]}  /* FPSCR */                     \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S15 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S14 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S13 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S12 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S11 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S10 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S9 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S8 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S7 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S6 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S5 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S4 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S3 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S2 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S1 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S0 */                        \n"
-#endif
-                 "stmdb   %[stack]!, {%[psr]}   /* xPSR */                      \n\
+    /*
+     * New tasks have no floating point context, so the context consists of
+     * a basic hardware frame and the software saved registers.  If the task
+     * uses the FPU, the hardware will begin stacking an extended frame, and
+     * the FPU registers will be saved, as indicated by the saved EXC_RETURN.
+     */
+    asm volatile("stmdb   %[stack]!, {%[psr]}   /* xPSR */                      \n\
                   stmdb   %[stack]!, {%[pc]}    /* PC */                        \n\
                   stmdb   %[stack]!, {%[lr]}    /* LR */                        \n\
                   stmdb   %[stack]!, {%[zero]}  /* R12 */                       \n\
@@ -86,30 +130,94 @@ void create_context(task_ctrl* task, void (*lptr)(void)) {
                   stmdb   %[stack]!, {%[frame]} /* R7 - Frame Pointer*/         \n\
                   stmdb   %[stack]!, {%[zero]}  /* R6 */                        \n\
                   stmdb   %[stack]!, {%[zero]}  /* R5 */                        \n\
-                  stmdb   %[stack]!, {%[zero]}  /* R4 */                        \n"
-#ifdef CONFIG_HAVE_FPU
-                 "stmdb   %[stack]!, {%[zero]}  /* S31 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S30 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S29 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S28 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S27 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S26 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S25 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S24 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S23 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S22 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S21 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S20 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S19 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S18 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S17 */                       \n\
-                  stmdb   %[stack]!, {%[zero]}  /* S16 */"
-#endif
+                  stmdb   %[stack]!, {%[zero]}  /* R4 */                        \n\
+                  stmdb   %[stack]!, {%[exc]}   /* EXC_RETURN */"
                   /* Output */
                   :[stack] "+r" (task->stack_top)
                   /* Input */
                   :[pc] "r" (task->fptr), [lr] "r" (lptr), [frame] "r" (task->stack_limit),
-                   [zero] "r" (0), [psr] "r" (0x01000000) /* Set the Thumb bit */
+                   [zero] "r" (0), [psr] "r" (0x01000000), /* Set the Thumb bit */
+                   [exc] "r" (EXC_RETURN_THREAD_PSP)
                   /* Clobber */
                   :);
 }
+
+#ifdef CONFIG_TICKLESS_IDLE
+/* Ticks programmed by arch_sched_suppress_ticks() */
+static uint32_t suppressed_ticks;
+
+void arch_sched_mask_interrupts(void) {
+    asm volatile ("cpsid    i" ::: "memory");
+}
+
+void arch_sched_unmask_interrupts(void) {
+    asm volatile ("cpsie    i" ::: "memory");
+}
+
+uint32_t arch_sched_suppress_ticks(uint32_t ticks) {
+    uint32_t max = SYSTICK_RELOAD_MAX / SYSTICK_PERIOD;
+    uint32_t remaining;
+
+    if (max < 2) {
+        return 0;
+    }
+
+    if (ticks > max) {
+        ticks = max;
+    }
+
+    *SYSTICK_CTL &= ~SYSTICK_CTL_ENABLE;
+
+    /* A tick is already pending, it can't be merged with the suppressed ticks */
+    if (*SCB_ICSR & SCB_ICSR_PENDSTSET) {
+        *SYSTICK_CTL |= SYSTICK_CTL_ENABLE;
+        return 0;
+    }
+
+    /*
+     * Fire once, after the remainder of the current tick period,
+     * plus the rest of the suppressed periods.
+     */
+    remaining = *SYSTICK_VAL;
+    *SYSTICK_RELOAD = remaining + (ticks - 1) * SYSTICK_PERIOD;
+    *SYSTICK_VAL = 0;
+    *SYSTICK_CTL |= SYSTICK_CTL_ENABLE;
+
+    suppressed_ticks = ticks;
+
+    return ticks;
+}
+
+uint32_t arch_sched_resume_ticks(void) {
+    uint32_t elapsed, remaining, val;
+
+    *SYSTICK_CTL &= ~SYSTICK_CTL_ENABLE;
+    val = *SYSTICK_VAL;
+
+    if (!val || (*SCB_ICSR & SCB_ICSR_PENDSTSET)) {
+        /* Suppression complete, the final tick is pending */
+        uint32_t since = *SYSTICK_RELOAD - val;
+
+        elapsed = suppressed_ticks - 1;
+        remaining = since < SYSTICK_PERIOD ? SYSTICK_PERIOD - since : 1;
+    }
+    else {
+        /* Woken early, val counts down to the final tick */
+        uint32_t future = DIV_ROUND_UP(val, SYSTICK_PERIOD);
+
+        elapsed = suppressed_ticks - future;
+        remaining = ((val - 1) % SYSTICK_PERIOD) + 1;
+    }
+
+    /*
+     * Run out the current tick period, then reload with the normal
+     * period, which takes effect once the counter reaches zero.
+     */
+    *SYSTICK_RELOAD = remaining;
+    *SYSTICK_VAL = 0;
+    *SYSTICK_CTL |= SYSTICK_CTL_ENABLE;
+    *SYSTICK_RELOAD = SYSTICK_PERIOD;
+
+    return elapsed;
+}
+#endif
@@ -24,7 +24,14 @@
 #include <kernel/fault.h>
 #include <kernel/sched.h>
 #include <kernel/sched_internals.h>
+#include <kernel/event.h>
+#include <kernel/hrtimer.h>
+#include <kernel/msg_queue.h>
 #include <kernel/mutex.h>
+#include <kernel/rwlock.h>
+#include <kernel/semaphore.h>
+#include <kernel/tasklet.h>
+#include <kernel/trace.h>
 
 void svc_handler(uint32_t*) __attribute__((section(".kernel")));
 
@@ -36,11 +43,15 @@ void svc_handler(uint32_t *registers) {
      * First argument and return value (r0) is registers[0] */
     svc_number = ((char *)registers[6])[-2];
 
+    trace_record(TRACE_SVC, svc_number);
+
     switch (svc_number) {
         case SVC_YIELD:
         case SVC_END_TASK:
         case SVC_REGISTER_TASK:
         case SVC_TASK_SWITCH:
+        case SVC_SLEEP:
+        case SVC_TASK_STATS:
             registers[0] = sched_service_call(svc_number, registers[0],
                                               registers[1]);
             break;
@@ -48,6 +59,41 @@ void svc_handler(uint32_t *registers) {
         case SVC_RELEASE:
             registers[0] = mutex_service_call(svc_number, registers[0]);
             break;
+        case SVC_SEM_WAIT:
+        case SVC_SEM_POST:
+            registers[0] = semaphore_service_call(svc_number, registers[0],
+                                                  registers[1]);
+            break;
+        case SVC_EVENT_WAIT:
+        case SVC_EVENT_SET:
+            registers[0] = event_service_call(svc_number, registers[0],
+                                              registers[1]);
+            break;
+        case SVC_MSG_QUEUE_SEND:
+        case SVC_MSG_QUEUE_RECEIVE:
+            registers[0] = msg_queue_service_call(svc_number, registers[0],
+                                                  registers[1]);
+            break;
+        case SVC_RWLOCK_READ_ACQUIRE:
+        case SVC_RWLOCK_READ_RELEASE:
+        case SVC_RWLOCK_WRITE_ACQUIRE:
+        case SVC_RWLOCK_WRITE_RELEASE:
+            registers[0] = rwlock_service_call(svc_number, registers[0]);
+            break;
+#ifdef CONFIG_HRTIMER
+        case SVC_HRTIMER_START:
+        case SVC_HRTIMER_CANCEL:
+            registers[0] = hrtimer_service_call(svc_number, registers[0],
+                                                registers[1]);
+            break;
+#endif
+#ifdef CONFIG_TASKLETS
+        case SVC_TASKLET_START:
+        case SVC_TASKLET_STOP:
+            registers[0] = tasklet_service_call(svc_number, registers[0],
+                                                registers[1]);
+            break;
+#endif
         default:
             panic_print("Unknown SVC: %d", svc_number);
             break;
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic.h>
+#include <stdint.h>
+#include <arch/mpu.h>
+#include <arch/system.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+
+/*
+ * The highest numbered region takes priority over all others, so the guard
+ * remains in effect even if other regions are added later.
+ */
+#define STACK_GUARD_REGION      7
+
+/* Smallest region the MPU supports, which must be aligned to its size */
+#define STACK_GUARD_SIZE        32
+#define STACK_GUARD_SIZE_FIELD  4   /* 2^(4+1) bytes */
+
+static uintptr_t stack_guard_base = 0;
+
+/* Address mpu_probe() is reading, and whether the read faulted */
+static volatile uintptr_t probe_addr = 0;
+static volatile int probe_faulted = 0;
+
+void init_mpu(void) {
+    *MPU_RNR = STACK_GUARD_REGION;
+    *MPU_RASR = 0;
+
+    /* Enable the memory management fault, rather than escalating to hard fault */
+    *SCB_SHCSR |= SCB_SHCSR_MEMFAULTENA;
+
+    /* Enable the MPU and allow privileged access to the background map */
+    *MPU_CTRL |= MPU_CTRL_ENABLE | MPU_CTRL_PRIVDEFENA;
+
+    /* The new memory map applies to all following accesses */
+    DSB();
+    ISB();
+}
+
+/* The guard starts at the first region-aligned address in the stack */
+static uintptr_t stack_guard(task_ctrl *task) {
+    uintptr_t base = (uintptr_t) task->stack_limit;
+
+    return (base + STACK_GUARD_SIZE - 1) & ~(STACK_GUARD_SIZE - 1);
+}
+
+/*
+ * Protect the bottom of the stack of the task being switched to with a
+ * no-access region, so an overflow faults on the first access past the end
+ * of the stack, rather than corrupting the memory below it.
+ *
+ * Up to 2 * STACK_GUARD_SIZE - 1 bytes of each stack are unusable.
+ *
+ * Called from the task switch, in handler mode.  The barriers ensure the
+ * region is in place before anything else runs, including the rest of the
+ * switch, which may touch the new task's stack.
+ */
+int arch_sched_stack_guard(task_ctrl *task) {
+    uintptr_t base = stack_guard(task);
+
+    stack_guard_base = base;
+
+    *MPU_RNR = STACK_GUARD_REGION;
+    *MPU_RBAR = base;
+    *MPU_RASR = MPU_RASR_ENABLE | MPU_RASR_SIZE(STACK_GUARD_SIZE_FIELD) |
+                MPU_RASR_SHARE_CACHE_WBACK | MPU_RASR_AP_PRIV_NO_UN_NO |
+                MPU_RASR_XN;
+
+    DSB();
+    ISB();
+
+    return 1;
+}
+
+uint32_t *arch_sched_stack_guard_end(task_ctrl *task) {
+    return (uint32_t *) (stack_guard(task) + STACK_GUARD_SIZE);
+}
+
+int mpu_stack_guard_hit(uintptr_t addr) {
+    return addr >= stack_guard_base &&
+           addr < stack_guard_base + STACK_GUARD_SIZE;
+}
+
+int mpu_probe(volatile uint32_t *addr) {
+    probe_faulted = 0;
+    probe_addr = (uintptr_t) addr;
+    smp_mb();
+
+    (void) *addr;
+
+    smp_mb();
+    probe_addr = 0;
+
+    return probe_faulted;
+}
+
+/* 32-bit Thumb-2 instructions start with 0b11101, 0b11110, or 0b11111 */
+static int thumb_instruction_size(uint16_t halfword) {
+    return (halfword >> 11) >= 0x1d ? 4 : 2;
+}
+
+int mpu_probe_fault(void) {
+    uint32_t status = *SCB_CFSR & 0xff;
+    uint32_t *frame;
+
+    /* Only the probe's own read, not any other fault while it is set */
+    if (!probe_addr || !(status & SCB_MMFSR_MMARVALID) ||
+            *SCB_MMFAR != probe_addr) {
+        return 0;
+    }
+
+    probe_addr = 0;
+    probe_faulted = 1;
+
+    /* Clear the fault status, including the fault address valid bit */
+    *SCB_CFSR = status;
+
+    /* Return to the instruction after the faulting read, on the task stack */
+    frame = PSP();
+    frame[6] += thumb_instruction_size(*(uint16_t *) frame[6]);
+
+    return 1;
+}
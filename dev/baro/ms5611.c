@@ -29,6 +29,7 @@
 #include <dev/fdtparse.h>
 #include <dev/hw/i2c.h>
 #include <dev/baro.h>
+#include <kernel/hrtimer.h>
 #include <kernel/init.h>
 #include <kernel/mutex.h>
 #include <mm/mm.h>
@@ -42,6 +43,9 @@ struct ms5611 {
 
 #define MS5611_COMPAT    "meas-spec,ms5611-01ba03"
 
+/* Maximum conversion time at OSR 4096 */
+#define MS5611_CONVERSION_US    9040
+
 static int ms5611_init(struct baro *baro) {
     struct i2c *i2c = to_i2c(baro->device.parent);
     struct i2c_ops *i2c_ops = (struct i2c_ops *)i2c->obj.ops;
@@ -144,8 +148,8 @@ static int ms5611_get_data(struct baro *baro, struct baro_data *data) {
         goto err_release_mut;
     }
 
-    /* Wait 10ms for conversion */
-    usleep(10000);
+    /* Wait for conversion */
+    hrtimer_usleep(MS5611_CONVERSION_US);
 
     /* Digital pressure value */
     ret = ms5611_read_adc(i2c, ms5611_baro->addr, &d1);
@@ -159,8 +163,8 @@ static int ms5611_get_data(struct baro *baro, struct baro_data *data) {
         goto err_release_mut;
     }
 
-    /* Wait 10ms for conversion */
-    usleep(10000);
+    /* Wait for conversion */
+    hrtimer_usleep(MS5611_CONVERSION_US);
 
     /* Digital temperature value */
     ret = ms5611_read_adc(i2c, ms5611_baro->addr, &d2);
@@ -29,11 +29,13 @@
 #include <kernel/class.h>
 #include <kernel/obj.h>
 #include <kernel/mutex.h>
+#include <kernel/rwlock.h>
 #include <mm/mm.h>
 #include <dev/device.h>
 
+/* Looked up far more often than registered, so lookups share the lock */
 struct list drivers = INIT_LIST(drivers);
-struct mutex driver_mut = INIT_MUTEX;
+struct rwlock drivers_lock = INIT_RWLOCK(drivers_lock);
 
 struct list compat_drivers = INIT_LIST(compat_drivers);
 struct mutex compat_driver_mut = INIT_MUTEX;
@@ -44,14 +46,14 @@ struct obj *device_get(const char *name) {
     struct obj *obj = NULL;
     int exists;
 
-    acquire(&driver_mut);
+    read_acquire(&drivers_lock);
     list_for_each_entry(iter, &drivers, list) {
         if (strcmp(name, iter->name) == 0) {
             driver = iter;
             break;
         }
     }
-    release(&driver_mut);
+    read_release(&drivers_lock);
 
     /* No driver, too bad... */
     if (!driver) {
@@ -89,9 +91,9 @@ out:
 }
 
 void device_driver_register(struct device_driver *driver) {
-    acquire(&driver_mut);
+    write_acquire(&drivers_lock);
     list_add(&driver->list, &drivers);
-    release(&driver_mut);
+    write_release(&drivers_lock);
 }
 
 void device_compat_driver_register(struct device_driver *driver) {
@@ -195,7 +197,7 @@ int device_list_class(struct class *class, const char **names, int max) {
     struct device_driver *driver;
     int total = 0;
 
-    acquire(&driver_mut);
+    read_acquire(&drivers_lock);
     list_for_each_entry(driver, &drivers, list) {
         if (driver->class == class) {
             if (total < max) {
@@ -204,7 +206,7 @@ int device_list_class(struct class *class, const char **names, int max) {
             total++;
         }
     }
-    release(&driver_mut);
+    read_release(&drivers_lock);
 
     return total;
 }
@@ -175,6 +175,19 @@ static uint8_t store_conditional32(volatile uint32_t *address, uint32_t value);
 static uint8_t store_conditional16(volatile uint16_t *address, uint16_t value);
 static uint8_t store_conditional8(volatile uint8_t *address, uint8_t value);
 
+/**
+ * Memory barriers
+ *
+ * Ensure that explicit memory accesses before the barrier are observed
+ * before those after it, by both the CPU and other bus masters (e.g., DMA).
+ * Each also acts as a compiler barrier.
+ *
+ * smp_mb orders all accesses, smp_rmb orders loads, and smp_wmb orders stores.
+ */
+static void smp_mb(void);
+static void smp_rmb(void);
+static void smp_wmb(void);
+
 /* 32-bit default implementation */
 #define load_link           load_link32
 #define store_conditional   store_conditional32
@@ -36,10 +36,17 @@
 
 #include <list.h>
 #include <kernel/obj.h>
-#include <kernel/reentrant_mutex.h>
+#include <kernel/rwlock.h>
 
+/*
+ * Lookups share the lock, while collection_lock(), iteration, and
+ * modification hold it exclusively.  The exclusive hold is reentrant, and
+ * its holder may also look up members.
+ */
 struct collection {
-    struct reentrant_mutex lock;
+    struct rwlock lock;
+    task_t *held_by;
+    int count;
     struct list list;
     struct list *curr;
 };
@@ -54,7 +61,9 @@ struct collection {
  *
  * @param c symbol name of collection
  */
-#define INIT_COLLECTION(c) { .lock = INIT_REENTRANT_MUTEX, \
+#define INIT_COLLECTION(c) { .lock = INIT_RWLOCK((c).lock), \
+                             .held_by = NULL, \
+                             .count = 0, \
                              .list = INIT_LIST((c).list), \
                              .curr = NULL, \
                            }
@@ -67,7 +76,9 @@ struct collection {
  * @param c collection to initialize
  */
 static inline void init_collection(struct collection *c) {
-    init_reentrant_mutex(&c->lock);
+    init_rwlock(&c->lock);
+    c->held_by = NULL;
+    c->count = 0;
     list_init(&c->list);
     c->curr = NULL;
 }
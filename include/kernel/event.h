@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef KERNEL_EVENT_H_INCLUDED
+#define KERNEL_EVENT_H_INCLUDED
+
+#include <stdint.h>
+#include <list.h>
+
+/*
+ * Event flag group
+ *
+ * 32 event flags, which tasks may wait on until any or all of a set of
+ * flags are set.  Waiting tasks are blocked on waiters.
+ */
+struct event_group {
+    uint32_t    flags;
+    struct list waiters;
+};
+
+/* Wait until any of the requested flags are set */
+#define EVENT_WAIT_ANY      (0)
+/* Wait until all of the requested flags are set */
+#define EVENT_WAIT_ALL      (1 << 0)
+/* Clear the requested flags when the wait is satisfied */
+#define EVENT_WAIT_CLEAR    (1 << 1)
+
+/*
+ * Statically initialize event group
+ *
+ * struct event_group group = INIT_EVENT_GROUP(group);
+ *
+ * @param name  Name of event group being initialized
+ */
+#define INIT_EVENT_GROUP(name) {            \
+    .flags = 0,                             \
+    .waiters = INIT_LIST((name).waiters),   \
+}
+
+/*
+ * Dynamically initialize event group
+ *
+ * @param group Event group to initialize
+ */
+static inline void init_event_group(struct event_group *group) {
+    group->flags = 0;
+    list_init(&group->waiters);
+}
+
+/*
+ * Wait for event flags
+ *
+ * Blocks until the requested flags are set, according to mode, or
+ * timeout_us microseconds pass.
+ *
+ * Must not be called from interrupt context.
+ *
+ * @param group         Event group to wait on
+ * @param flags         Flags to wait for
+ * @param mode          EVENT_WAIT_ANY or EVENT_WAIT_ALL, optionally ORed
+ *                      with EVENT_WAIT_CLEAR
+ * @param timeout_us    Microseconds to wait, 0 to return immediately, or
+ *                      TIMEOUT_FOREVER
+ * @param received      If not NULL, set to the group flags which satisfied
+ *                      the wait, before any are cleared
+ * @returns 0 on success, negative on timeout
+ */
+int event_wait(struct event_group *group, uint32_t flags, uint8_t mode,
+               uint32_t timeout_us, uint32_t *received);
+
+/*
+ * Set event flags
+ *
+ * Sets flags in the group, waking all waiters whose wait is satisfied.
+ *
+ * May be called from interrupt context.  A task woken from interrupt
+ * context preempts the current task, if it should, once interrupt
+ * handlers return.
+ *
+ * @param group Event group to modify
+ * @param flags Flags to set
+ */
+void event_set(struct event_group *group, uint32_t flags);
+
+/*
+ * Clear event flags
+ *
+ * May be called from interrupt context.
+ *
+ * @param group Event group to modify
+ * @param flags Flags to clear
+ */
+void event_clear(struct event_group *group, uint32_t flags);
+
+/**
+ * Event service call handler
+ * Should only be called by global SVC handler.  This takes va_args for the
+ * event service calls and returns the result of the service call.
+ *
+ * @param svc_number    Service call number.  Must be an event service call
+ * @param va_args       Arguments for service call
+ * @returns Return value of service call
+ */
+int event_service_call(uint32_t svc_number, ...);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef KERNEL_HRTIMER_H_INCLUDED
+#define KERNEL_HRTIMER_H_INCLUDED
+
+#include <stdint.h>
+#include <list.h>
+#include <time.h>
+
+/*
+ * High resolution one-shot timers
+ *
+ * With CONFIG_HRTIMER, timers expire with sub-tick resolution, driven by a
+ * hardware timer compare programmed for the earliest pending expiration.
+ * Pending timers are kept sorted by expiration.
+ *
+ * Expiration callbacks run in interrupt context, so they must not block.
+ * They may restart their own timer.
+ */
+struct hrtimer {
+    struct list list;
+    uint64_t    expires;    /* clock_monotonic_ns() at expiration */
+    void        (*func)(struct hrtimer *timer);
+    uint8_t     active;
+};
+
+/*
+ * Statically initialize timer
+ *
+ * struct hrtimer timer = INIT_HRTIMER(timer, callback);
+ *
+ * @param name  Name of timer being initialized
+ * @param fn    Callback run when the timer expires
+ */
+#define INIT_HRTIMER(name, fn) {        \
+    .list = INIT_LIST((name).list),     \
+    .expires = 0,                       \
+    .func = (fn),                       \
+    .active = 0,                        \
+}
+
+/*
+ * Dynamically initialize timer
+ *
+ * @param timer Timer to initialize
+ * @param func  Callback run when the timer expires
+ */
+static inline void init_hrtimer(struct hrtimer *timer,
+                                void (*func)(struct hrtimer *timer)) {
+    list_init(&timer->list);
+    timer->expires = 0;
+    timer->func = func;
+    timer->active = 0;
+}
+
+#ifdef CONFIG_HRTIMER
+
+/*
+ * Start timer
+ *
+ * The timer expires delay_ns nanoseconds from now.  If it is already
+ * pending, it is restarted with the new delay.
+ *
+ * May be called from any context.
+ *
+ * @param timer     Timer to start
+ * @param delay_ns  Nanoseconds until expiration
+ * @returns 1 if the timer was pending, 0 otherwise
+ */
+int hrtimer_start(struct hrtimer *timer, uint32_t delay_ns);
+
+/*
+ * Cancel timer
+ *
+ * May be called from any context.  The callback will not run after
+ * hrtimer_cancel() returns, unless the timer is started again.
+ *
+ * @param timer Timer to cancel
+ * @returns 1 if the timer was pending, 0 otherwise
+ */
+int hrtimer_cancel(struct hrtimer *timer);
+
+/*
+ * Microsecond sleep, with sub-tick precision
+ *
+ * Blocks until usecs microseconds pass, rather than rounding up to system
+ * ticks like usleep().  Falls back to usleep() where blocking isn't
+ * possible.
+ *
+ * @param usecs Microseconds to sleep
+ * @returns 0 on success
+ */
+int hrtimer_usleep(uint32_t usecs);
+
+/*
+ * Run expired timers
+ *
+ * Called from the arch timer interrupt.  Runs the callbacks of all expired
+ * timers, then programs the arch timer for the next expiration.
+ */
+void hrtimer_interrupt(void);
+
+int hrtimer_service_call(uint32_t svc_number, ...);
+
+/*
+ * Arch specific implementation
+ */
+
+/*
+ * Program the timer interrupt
+ *
+ * Call hrtimer_interrupt() delay_ns nanoseconds from now, replacing any
+ * previously programmed interrupt.  Very short delays may be rounded up
+ * to the minimum the hardware can program.
+ *
+ * @param delay_ns  Nanoseconds until interrupt
+ */
+void arch_hrtimer_program(uint32_t delay_ns);
+
+/*
+ * Stop the timer interrupt
+ *
+ * Cancel any previously programmed interrupt.
+ */
+void arch_hrtimer_stop(void);
+
+#else
+
+static inline int hrtimer_usleep(uint32_t usecs) {
+    return usleep(usecs);
+}
+
+#endif
+
+#endif
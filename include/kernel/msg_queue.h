@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef KERNEL_MSG_QUEUE_H_INCLUDED
+#define KERNEL_MSG_QUEUE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+
+/*
+ * Bounded message queue
+ *
+ * Holds up to capacity messages of msg_size bytes each, copied in and out
+ * of buffer.  Tasks blocked sending to a full queue, or receiving from an
+ * empty one, wait on send_waiters or receive_waiters, in priority order.
+ *
+ * Messages are handed directly between a sender and a blocked receiver,
+ * and from a blocked sender into a slot freed by a receiver, so message
+ * order is preserved.
+ */
+struct msg_queue {
+    uint8_t     *buffer;
+    size_t      msg_size;
+    uint32_t    capacity;
+    uint32_t    head;       /* Slot of the oldest message */
+    uint32_t    count;
+    struct list send_waiters;
+    struct list receive_waiters;
+};
+
+/*
+ * Statically define message queue
+ *
+ * DEFINE_MSG_QUEUE(name, sizeof(struct sample), 16);
+ *
+ * @param name      Name of queue
+ * @param size      Size of each message, in bytes
+ * @param num       Maximum number of queued messages
+ */
+#define DEFINE_MSG_QUEUE(name, size, num)                               \
+    static uint8_t name##_buffer[(size) * (num)]                        \
+        __attribute__((aligned(4)));                                    \
+    struct msg_queue name = {                                           \
+        .buffer = name##_buffer,                                        \
+        .msg_size = (size),                                             \
+        .capacity = (num),                                              \
+        .head = 0,                                                      \
+        .count = 0,                                                     \
+        .send_waiters = INIT_LIST(name.send_waiters),                   \
+        .receive_waiters = INIT_LIST(name.receive_waiters),             \
+    }
+
+/*
+ * Dynamically initialize message queue
+ *
+ * @param queue     Queue to initialize
+ * @param buffer    Storage for messages, at least size * num bytes
+ * @param size      Size of each message, in bytes
+ * @param num       Maximum number of queued messages
+ */
+static inline void init_msg_queue(struct msg_queue *queue, void *buffer,
+                                  size_t size, uint32_t num) {
+    queue->buffer = buffer;
+    queue->msg_size = size;
+    queue->capacity = num;
+    queue->head = 0;
+    queue->count = 0;
+    list_init(&queue->send_waiters);
+    list_init(&queue->receive_waiters);
+}
+
+/*
+ * Send message
+ *
+ * Copies msg_size bytes from msg onto the tail of the queue, blocking while
+ * the queue is full, until timeout_us microseconds pass.
+ *
+ * Must not be called from interrupt context.  See msg_queue_post().
+ *
+ * @param queue         Queue to send to
+ * @param msg           Message to send
+ * @param timeout_us    Microseconds to wait, 0 to return immediately, or
+ *                      TIMEOUT_FOREVER
+ * @returns 0 on success, negative if the queue remained full
+ */
+int msg_queue_send(struct msg_queue *queue, const void *msg,
+                   uint32_t timeout_us);
+
+/*
+ * Receive message
+ *
+ * Copies msg_size bytes from the head of the queue into msg, blocking while
+ * the queue is empty, until timeout_us microseconds pass.
+ *
+ * Must not be called from interrupt context.
+ *
+ * @param queue         Queue to receive from
+ * @param msg           Buffer to receive message into
+ * @param timeout_us    Microseconds to wait, 0 to return immediately, or
+ *                      TIMEOUT_FOREVER
+ * @returns 0 on success, negative if the queue remained empty
+ */
+int msg_queue_receive(struct msg_queue *queue, void *msg,
+                      uint32_t timeout_us);
+
+/*
+ * Post message without blocking
+ *
+ * Like msg_queue_send() with no timeout, but may be called from interrupt
+ * context.  A task woken from interrupt context preempts the current task,
+ * if it should, once interrupt handlers return.
+ *
+ * @param queue Queue to send to
+ * @param msg   Message to send
+ * @returns 0 on success, negative if the queue is full
+ */
+int msg_queue_post(struct msg_queue *queue, const void *msg);
+
+/*
+ * Zero-copy messages
+ *
+ * For queues with a msg_size of sizeof(void *), pass only a pointer to a
+ * buffer.  Sending a buffer passes ownership of it to the receiver, so the
+ * sender must not touch it after a successful send.
+ *
+ * Each returns negative, without touching the queue, if the queue's
+ * messages are not pointer sized, since copying msg_size bytes would
+ * overrun the pointer.
+ */
+static inline int msg_queue_send_ptr(struct msg_queue *queue, void *ptr,
+                                     uint32_t timeout_us) {
+    if (queue->msg_size != sizeof(ptr)) {
+        return -1;
+    }
+
+    return msg_queue_send(queue, &ptr, timeout_us);
+}
+
+static inline int msg_queue_receive_ptr(struct msg_queue *queue, void **ptr,
+                                        uint32_t timeout_us) {
+    if (queue->msg_size != sizeof(*ptr)) {
+        return -1;
+    }
+
+    return msg_queue_receive(queue, ptr, timeout_us);
+}
+
+static inline int msg_queue_post_ptr(struct msg_queue *queue, void *ptr) {
+    if (queue->msg_size != sizeof(ptr)) {
+        return -1;
+    }
+
+    return msg_queue_post(queue, &ptr);
+}
+
+/**
+ * Message queue service call handler
+ * Should only be called by global SVC handler.  This takes va_args for the
+ * message queue service calls and returns the result of the service call.
+ *
+ * @param svc_number    Service call number.  Must be a message queue
+ *                      service call
+ * @param va_args       Arguments for service call
+ * @returns Return value of service call
+ */
+int msg_queue_service_call(uint32_t svc_number, ...);
+
+#endif
@@ -25,23 +25,44 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <list.h>
 
 #define HELD_MUTEXES_MAX         CONFIG_HELD_MUTEXES_MAX
 
 struct task_t;
 typedef struct task_t task_t;
+struct rwlock;
 
+/*
+ * The lock word holds the address of the owning task, or 0 if unlocked.
+ * Uncontended acquire and release update it atomically from the calling
+ * task, and only enter the kernel when it is held or has waiters.
+ *
+ * Tasks waiting on the mutex are blocked on waiters, in priority order.
+ * The list is only valid while MUTEX_CONTENDED is set, so mutexes need
+ * no list initialization.
+ */
 struct mutex {
-        uint8_t lock;
-        task_t  *held_by;
-        task_t  *waiting;
+        uint32_t    lock;
+        struct list waiters;
 };
 
 typedef struct mutex mutex;
 
+/* Set in lock while other tasks are waiting, forcing release into the
+ * kernel to hand the mutex off */
+#define MUTEX_CONTENDED     (1 << 0)
+
+/* Task holding mutex, or NULL if unlocked */
+static inline task_t *mutex_owner(volatile struct mutex *mutex) {
+    return (task_t *) (mutex->lock & ~MUTEX_CONTENDED);
+}
+
 struct task_mutex_data {
     struct mutex   *held_mutexes[HELD_MUTEXES_MAX];
-    struct mutex   *waiting;
+    struct rwlock  *held_rwlocks[HELD_MUTEXES_MAX];  /* Held while contended */
+    struct mutex   *waiting;    /* Mutex blocked on */
+    struct list     wait_list;  /* Entry in waiting->waiters */
 };
 
 void acquire(volatile struct mutex *mutex);
@@ -50,19 +71,26 @@ void release(volatile struct mutex *mutex);
 
 static inline void init_mutex(volatile struct mutex *mutex) {
     mutex->lock = 0;
-    mutex->held_by = NULL;
-    mutex->waiting = NULL;
 }
 
 #define INIT_MUTEX  {\
     .lock = 0,          \
-    .held_by = NULL,    \
-    .waiting = NULL,    \
 }
 
 /* Setup mutex data structure for a new task */
 void task_mutex_setup(task_t *task);
 
+/*
+ * Update the inherited priority, and under EDF the deadline, of task
+ *
+ * Called from kernel context when the waiters on mutexes or rwlocks held
+ * by task change.  If task is itself blocked on a mutex, the change is
+ * propagated to the owner of that mutex, and so on down the chain.
+ *
+ * @param task  Task whose inheritance changed
+ */
+void priority_inherit(task_t *task);
+
 /**
  * Semaphore service call handler
  * Should only be called by global SVC handler.  This takes va_args for the
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef KERNEL_RWLOCK_H_INCLUDED
+#define KERNEL_RWLOCK_H_INCLUDED
+
+#include <stdint.h>
+#include <list.h>
+
+struct task_t;
+typedef struct task_t task_t;
+
+#define RWLOCK_READERS_MAX  CONFIG_RWLOCK_READERS_MAX
+
+/*
+ * Reader-writer lock
+ *
+ * Any number of readers, up to RWLOCK_READERS_MAX, may hold the lock at
+ * once, or a single writer.  Writers are preferred: once a writer is
+ * waiting, new readers wait behind it, so a steady stream of readers
+ * cannot starve writers.
+ *
+ * Each reader holds a slot naming it.  Readers claim and clear their slot
+ * atomically from the calling task, and only enter the kernel when a task
+ * must block or be woken.  Writers always take and drop the lock through
+ * the kernel, as lookups far outnumber writes for the structures rwlocks
+ * protect.
+ *
+ * While tasks wait, the holders inherit their priority, or deadline under
+ * CONFIG_SCHED_POLICY_EDF, as mutex owners do.  Inheritance passes on
+ * through mutexes a holder is blocked on, but not through another rwlock.
+ *
+ * Unlike mutexes, rwlocks are not reentrant.  A reader must not acquire
+ * the lock again, as a writer may be waiting between them.
+ */
+struct rwlock {
+    uint32_t    state;
+    task_t      *writer;        /* Task holding the write lock, if any */
+    uint32_t    readers[RWLOCK_READERS_MAX];    /* Reading tasks, or 0 */
+    struct list read_waiters;
+    struct list write_waiters;
+};
+
+/* Held by a writer */
+#define RWLOCK_WRITER       (1 << 1)
+/* Set while tasks are waiting, forcing new readers into the kernel */
+#define RWLOCK_CONTENDED    (1 << 0)
+
+/* Set in a reader slot by the kernel, forcing the reader to release
+ * through the kernel */
+#define RWLOCK_READER_KERNEL    (1 << 0)
+
+/*
+ * Statically initialize rwlock
+ *
+ * struct rwlock lock = INIT_RWLOCK(lock);
+ *
+ * @param name  Name of rwlock being initialized
+ */
+#define INIT_RWLOCK(name) {                           \
+    .state = 0,                                       \
+    .writer = NULL,                                   \
+    .readers = { 0 },                                 \
+    .read_waiters = INIT_LIST((name).read_waiters),   \
+    .write_waiters = INIT_LIST((name).write_waiters), \
+}
+
+/*
+ * Dynamically initialize rwlock
+ *
+ * @param rw    rwlock to initialize
+ */
+static inline void init_rwlock(struct rwlock *rw) {
+    rw->state = 0;
+    rw->writer = NULL;
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        rw->readers[i] = 0;
+    }
+    list_init(&rw->read_waiters);
+    list_init(&rw->write_waiters);
+}
+
+/*
+ * Acquire rwlock for reading
+ *
+ * Blocks while a writer holds or is waiting for the lock, or all reader
+ * slots are taken.  Must not be called from interrupt context.
+ *
+ * @param rw    rwlock to acquire
+ */
+void read_acquire(struct rwlock *rw);
+
+/*
+ * Release rwlock held for reading
+ *
+ * @param rw    rwlock to release
+ */
+void read_release(struct rwlock *rw);
+
+/*
+ * Acquire rwlock for writing
+ *
+ * Blocks while any reader or writer holds the lock.  Must not be called
+ * from interrupt context.
+ *
+ * @param rw    rwlock to acquire
+ */
+void write_acquire(struct rwlock *rw);
+
+/*
+ * Release rwlock held for writing
+ *
+ * Hands the lock to the next waiting writer, if any, otherwise to all
+ * waiting readers.
+ *
+ * @param rw    rwlock to release
+ */
+void write_release(struct rwlock *rw);
+
+/*
+ * Priority inherited by task through rwlocks it holds
+ *
+ * Used by priority inheritance in kernel/mutex.c.
+ *
+ * @param task      Task holding rwlocks
+ * @param priority  Priority inherited so far
+ * @returns Highest of priority and that of any task waiting on an rwlock
+ *          task holds
+ */
+uint8_t rwlock_inherited_priority(task_t *task, uint8_t priority);
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+/*
+ * Deadline inherited by task through rwlocks it holds
+ *
+ * Used by priority inheritance in kernel/mutex.c.
+ *
+ * @param task      Task holding rwlocks
+ * @param found     Non-zero if deadline already holds an inherited deadline
+ * @param deadline  Earliest deadline inherited so far, updated with the
+ *                  deadline of any task waiting on an rwlock task holds
+ * @returns Non-zero if any deadline was inherited, including found
+ */
+int rwlock_inherited_deadline(task_t *task, int found, uint32_t *deadline);
+#endif
+
+int rwlock_service_call(uint32_t svc_number, ...);
+
+#endif
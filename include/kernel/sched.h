@@ -25,6 +25,7 @@
 
 #include <stdint.h>
 #include <compiler.h>
+#include <list.h>
 #include <dev/char.h>
 #include <kernel/mutex.h>
 #include <kernel/svc.h>
@@ -33,6 +34,15 @@
  * has begun task switching. */
 extern volatile uint8_t task_switching;
 
+/* State of a task blocked on a semaphore, event group, or message queue */
+struct task_wait_data {
+    struct list wait_list;  /* Entry in the wait list of the object */
+    int         status;     /* 0 if woken by the object, negative on timeout */
+    uint32_t    flags;      /* Event flags waited for, then received */
+    uint8_t     mode;       /* Event wait mode */
+    void        *data;      /* Message to send, or buffer to receive into */
+};
+
 /* Type used to refer to tasks from outside the scheduler.
  * Given a pointer to a task_t, the scheduler should be able
  * to uniquely identify a task.  This type also includes
@@ -40,6 +50,7 @@ extern volatile uint8_t task_switching;
  * the scheduler. */
 typedef struct task_t {
     struct task_mutex_data  mutex_data;
+    struct task_wait_data   wait_data;
     struct char_device      *_stdin;
     struct char_device      *_stdout;
     struct char_device      *_stderr;
@@ -72,6 +83,15 @@ void start_sched(void);
  */
 task_t *new_task(void (*fptr)(void), uint8_t priority, uint32_t period_us);
 
+/*
+ * Create a new task, with a stack of stack_words words
+ *
+ * new_task() uses a stack of CONFIG_TASK_STACK_SIZE words.  Tasks known at
+ * build time may instead use DEFINE_STATIC_TASK, in kernel/static_task.h.
+ */
+task_t *new_task_ex(void (*fptr)(void), uint8_t priority, uint32_t period_us,
+                    uint32_t stack_words);
+
 /* End-users set up boot tasks here.
  * This function will be run before scheduling starts, and
  * should be used to create the tasks that should run when
@@ -95,6 +115,70 @@ void generic_task_setup(task_t *task);
  * Returns 0 for equality, >0 if task1 is greater, <0 if task2 is greater */
 int task_compare(task_t *task1, task_t *task2);
 
+/* Get effective priority of task, including any inherited priority */
+uint8_t task_priority(task_t *task);
+
+/* Get priority task was created with */
+uint8_t task_base_priority(task_t *task);
+
+/*
+ * Set effective priority of task
+ *
+ * Used for priority inheritance.  If the task is runnable, it is moved to
+ * the tail of its new priority in the ready queue.  Must only be called from
+ * kernel context.
+ *
+ * With CONFIG_SCHED_POLICY_EDF, tasks scheduled by deadline ignore their
+ * priority, see task_inherit_deadline().
+ *
+ * @param task      Task to modify
+ * @param priority  New effective priority
+ */
+void task_set_priority(task_t *task, uint8_t priority);
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+/*
+ * Get effective deadline of task
+ *
+ * Tasks are scheduled by deadline if they are periodic, have an immediate
+ * deadline, or inherit a deadline from a task scheduled by deadline.
+ *
+ * @param task      Task to query
+ * @param deadline  Set to the absolute deadline of task, in system ticks,
+ *                  including any inherited deadline
+ * @returns 1 if task is scheduled by deadline, 0 if it is not
+ */
+int task_deadline(task_t *task, uint32_t *deadline);
+
+/*
+ * Set deadline inherited by task
+ *
+ * Used for priority inheritance.  A task inheriting a deadline is scheduled
+ * with the periodic tasks, by the earlier of its own deadline, if it has one,
+ * and the inherited deadline.  Must only be called from kernel
+ * context.
+ *
+ * @param task      Task to modify
+ * @param inherit   Non-zero to inherit deadline, 0 to stop inheriting
+ * @param deadline  Absolute deadline to inherit, in system ticks
+ * @returns 1 if the task's inherited deadline changed, 0 otherwise
+ */
+int task_inherit_deadline(task_t *task, int inherit, uint32_t deadline);
+
+/*
+ * Schedule a non-periodic task by deadline, due as soon as it is runnable
+ *
+ * Each time the task becomes runnable, its deadline is set to the current
+ * tick, so it runs ahead of periodic tasks whose deadlines are still to
+ * come, as the highest priority task does under fixed priorities.  Has no
+ * effect on periodic tasks.  Must only be called from kernel context, or
+ * before task switching begins.
+ *
+ * @param task      Task to modify
+ */
+void task_set_immediate_deadline(task_t *task);
+#endif
+
 /* Determine if a task is runnable.
  * Returns >0 if task is runnable, 0 if not.
  * A task may not be runnable because it doesn't exist,
@@ -102,6 +186,126 @@ int task_compare(task_t *task1, task_t *task2);
  * task between runs). */
 uint8_t task_runnable(task_t *task);
 
+/*
+ * Sleep current task
+ *
+ * Removes the current task from the scheduler for at least usecs
+ * microseconds.  The precision is one system tick period.
+ *
+ * Tasks can only sleep when task switching is active and not in
+ * interrupt context.
+ *
+ * @param usecs Microseconds to sleep
+ * @returns 0 after sleeping, negative if the task could not sleep
+ */
+int task_sleep(uint32_t usecs);
+
+/* Block indefinitely, until woken by task_wake() */
+#define TIMEOUT_FOREVER     UINT32_MAX
+
+/*
+ * Block task
+ *
+ * Remove a task from the scheduler until it is woken by task_wake(),
+ * or timeout_us microseconds pass.  This is the primitive on which
+ * blocking kernel calls are built, and must only be called from kernel
+ * context, such as a service call.
+ *
+ * The caller is responsible for switching away from the current task,
+ * if it was blocked.
+ *
+ * If the timeout expires, the task is also removed from the wait list it is
+ * linked into by wait_data.wait_list, if any.
+ *
+ * @param task          Task to block
+ * @param timeout_us    Microseconds until task is woken automatically, or
+ *                      TIMEOUT_FOREVER
+ */
+void task_block(task_t *task, uint32_t timeout_us);
+
+/*
+ * Wake blocked task
+ *
+ * Return a task blocked by task_block() to the scheduler.  No-op if the
+ * task is not blocked.  Must only be called from kernel context.
+ *
+ * @param task  Task to wake
+ */
+void task_wake(task_t *task);
+
+/*
+ * Block current task on a wait list
+ *
+ * Links curr_task into waiters by wait_data.wait_list, behind tasks of equal
+ * or greater priority, then blocks it and switches away.  The task is
+ * woken by task_wait_wake(), with wait_data.status set to 0, or when
+ * timeout_us expires, with wait_data.status negative.  Must only be called
+ * from a service call.
+ *
+ * @param waiters       Wait list of the object being waited on
+ * @param timeout_us    Microseconds until task times out, or TIMEOUT_FOREVER
+ */
+void task_wait(struct list *waiters, uint32_t timeout_us);
+
+/*
+ * Wake task blocked by task_wait()
+ *
+ * Removes the task from its wait list, and returns it to the scheduler.
+ * Must only be called from kernel or interrupt context.
+ *
+ * @param task  Task to wake
+ */
+void task_wait_wake(task_t *task);
+
+/*
+ * Determine if task was woken by a timeout
+ *
+ * @param task  Task to check
+ * @returns non-zero if task's last block ended because its timeout expired,
+ *          zero if it was woken by task_wake()
+ */
+int task_timed_out(task_t *task);
+
+/* Snapshot of a task's scheduling statistics */
+struct task_stats {
+    uint32_t    pid;
+    void        (*fptr)(void);
+    uint8_t     priority;
+    uint32_t    period;         /* in ticks */
+    uint64_t    runtime;        /* perfcounter counts spent running */
+    uint32_t    max_latency;    /* max perfcounter counts ready to running */
+    uint32_t    switches;       /* number of times switched to */
+    uint32_t    overruns;       /* periodic releases missed */
+    uint32_t    max_response;   /* worst periodic response time, in ticks */
+    uint32_t    stack_size;     /* in words */
+    uint32_t    stack_used;     /* high-water mark, in words */
+};
+
+/*
+ * Get scheduling statistics for all tasks
+ *
+ * runtime and max_latency are only measured with CONFIG_PERFCOUNTER, and
+ * are zero otherwise.
+ *
+ * @param stats Array to fill with statistics, one entry per task
+ * @param max   Number of entries in stats
+ * @returns Number of entries filled, or negative on error
+ */
+int task_stats(struct task_stats *stats, int max);
+
+/*
+ * Set periodic task overrun handler
+ *
+ * A periodic task which is still running, or blocked, at its next release
+ * overruns, and that release is skipped.  Overruns are counted in
+ * task_stats().  The handler is also called for each overrun, from the
+ * system tick interrupt, so it must not block.
+ *
+ * @param handler   Function called with the task that overran, or NULL
+ *                  for none
+ */
+void set_overrun_handler(void (*handler)(task_t *task));
+
 /* Switch to task
  * Immediately switches to task, as long as it is running.
  * Passing the NULL task is equivalent to yielding.
@@ -38,12 +38,31 @@ typedef struct task_ctrl {
     void        (*fptr)(void);
     uint32_t    period; /* in ticks */
     uint32_t    ticks_until_wake;
-    uint8_t     priority;
+    uint32_t    deadline; /* absolute, in ticks */
+    uint32_t    inherit_deadline; /* absolute, in ticks, if inheriting */
+    uint32_t    sleep_ticks;
+    uint8_t     priority;       /* effective, including inheritance */
+    uint8_t     base_priority;
+    uint8_t     inheriting;     /* EDF deadline inherited from a waiter */
+    uint8_t     immediate;      /* EDF deadline is when made runnable */
     uint8_t     running;
     uint8_t     abort;
+    uint8_t     blocked;
+    uint8_t     timed_out;
+    uint8_t     static_alloc;   /* defined with DEFINE_STATIC_TASK */
     uint32_t    pid;
+    uint64_t    runtime;            /* perfcounter counts spent running */
+    uint64_t    ready_timestamp;    /* perfcounter count when made ready */
+    uint32_t    max_latency;        /* max perfcounter counts ready to running */
+    uint32_t    switches;           /* number of times switched to */
+    uint32_t    release_time;       /* tick of last periodic release */
+    uint32_t    completion_time;    /* tick of last periodic completion */
+    uint32_t    max_response;       /* max ticks from release to completion */
+    uint32_t    overruns;           /* releases skipped while still running */
+    struct list all_task_list;
     struct list runnable_task_list;
     struct list periodic_task_list;
+    struct list sleep_task_list;
     struct list free_task_list;
     task_t      exported;
 } task_ctrl;
@@ -161,6 +180,59 @@ void arch_sched_start_bootstrap(void);
  */
 void sched_system_tick(void);
 
+/**
+ * Perform pended task switch
+ *
+ * Perform the task switch most recently requested while
+ * arch_sched_pend_switch() deferred switches, if any.
+ *
+ * Called by the arch with interrupts masked, once no other exception handler
+ * is active and the current task's context has been saved.
+ */
+void sched_pended_switch(void);
+
+/**
+ * Pend task switch
+ *
+ * Arrange for sched_pended_switch() to be called once no other exception
+ * handler is active, so handlers finish before switching, and several
+ * requests collapse into one switch.
+ *
+ * May be left undefined, so switches are performed immediately.  A weak
+ * version returning 0 will be provided.
+ *
+ * @returns 1 if the switch was pended, 0 if it must be performed immediately
+ */
+int arch_sched_pend_switch(void);
+
+/**
+ * Guard task stack
+ *
+ * Called when switching to a task, so the arch may protect the memory just
+ * above task->stack_limit, causing a fault as soon as the task overflows its
+ * stack.
+ *
+ * May be left undefined.  A weak version returning 0 will be provided.
+ *
+ * @param task  Task being switched to
+ * @returns 1 if the stack is guarded, 0 if overflow must be checked in software
+ */
+int arch_sched_stack_guard(task_ctrl *task);
+
+/**
+ * Get end of task stack guard
+ *
+ * The stack guard may not be accessed, even by the kernel, while the task
+ * is running.  It is never written by the task, so it remains painted.
+ *
+ * May be left undefined.  A weak version returning task->stack_limit will
+ * be provided.
+ *
+ * @param task  Task to get stack guard of
+ * @returns First word of the stack above the guard
+ */
+uint32_t *arch_sched_stack_guard_end(task_ctrl *task);
+
 /**
  * Enable arch system tick timer
  *
@@ -170,4 +242,65 @@ void sched_system_tick(void);
  */
 void arch_sched_start_system_tick(void);
 
+/**
+ * Get time since the last system tick
+ *
+ * Used to resolve time within a system tick.  If a tick has occurred but
+ * sched_system_tick() has not yet been called for it, the result includes
+ * that tick's period.
+ *
+ * May be left undefined.  A weak version returning 0 will be provided.
+ *
+ * @returns Nanoseconds since the last system tick handled
+ */
+uint32_t arch_sched_tick_elapsed_ns(void);
+
+/**
+ * Mask interrupts
+ *
+ * Prevent interrupts from being taken until arch_sched_unmask_interrupts().
+ * Pending interrupts must still wake the core from arch_wait_for_interrupt().
+ *
+ * Required for CONFIG_TICKLESS_IDLE.
+ */
+void arch_sched_mask_interrupts(void);
+
+/**
+ * Unmask interrupts
+ *
+ * Allow interrupts masked by arch_sched_mask_interrupts() to be taken.
+ *
+ * Required for CONFIG_TICKLESS_IDLE.
+ */
+void arch_sched_unmask_interrupts(void);
+
+/**
+ * Suppress system ticks
+ *
+ * Stop the periodic system tick, and instead program the system tick timer
+ * to call sched_system_tick() once, ticks system tick periods from the last
+ * system tick.  Called with interrupts masked.
+ *
+ * Required for CONFIG_TICKLESS_IDLE.
+ *
+ * @param ticks Number of system tick periods to suppress.  Must be > 1.
+ * @returns Number of system tick periods actually programmed, which may be
+ *          less than requested due to timer limitations.
+ */
+uint32_t arch_sched_suppress_ticks(uint32_t ticks);
+
+/**
+ * Resume system ticks
+ *
+ * Restore the periodic system tick after arch_sched_suppress_ticks().
+ * Called with interrupts masked.
+ *
+ * Required for CONFIG_TICKLESS_IDLE.
+ *
+ * @returns Number of complete system tick periods that elapsed while
+ *          suppressed, not including any pending system tick, which will
+ *          call sched_system_tick() itself.
+ */
+uint32_t arch_sched_resume_ticks(void);
+
 #endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef KERNEL_SEMAPHORE_H_INCLUDED
+#define KERNEL_SEMAPHORE_H_INCLUDED
+
+#include <stdint.h>
+#include <list.h>
+
+/*
+ * Counting semaphore
+ *
+ * Tasks waiting for the count to become non-zero are blocked on waiters,
+ * in priority order.
+ */
+struct semaphore {
+    uint32_t    count;
+    struct list waiters;
+};
+
+/*
+ * Statically initialize semaphore
+ *
+ * struct semaphore sem = INIT_SEMAPHORE(sem, 0);
+ *
+ * @param name  Name of semaphore being initialized
+ * @param n     Initial count
+ */
+#define INIT_SEMAPHORE(name, n) {           \
+    .count = (n),                           \
+    .waiters = INIT_LIST((name).waiters),   \
+}
+
+/*
+ * Dynamically initialize semaphore
+ *
+ * @param sem   Semaphore to initialize
+ * @param count Initial count
+ */
+static inline void init_semaphore(struct semaphore *sem, uint32_t count) {
+    sem->count = count;
+    list_init(&sem->waiters);
+}
+
+/*
+ * Wait on semaphore
+ *
+ * Decrements the semaphore count, blocking until it is non-zero, or
+ * timeout_us microseconds pass.
+ *
+ * Must not be called from interrupt context.
+ *
+ * @param sem           Semaphore to wait on
+ * @param timeout_us    Microseconds to wait, 0 to return immediately, or
+ *                      TIMEOUT_FOREVER
+ * @returns 0 on success, negative if the count was not decremented before
+ *          the timeout
+ */
+int sem_wait(struct semaphore *sem, uint32_t timeout_us);
+
+/*
+ * Post semaphore
+ *
+ * Increments the semaphore count, or hands it directly to the highest
+ * priority waiter.
+ *
+ * May be called from interrupt context.  A task woken from interrupt
+ * context preempts the current task, if it should, once interrupt
+ * handlers return.
+ *
+ * @param sem   Semaphore to post
+ */
+void sem_post(struct semaphore *sem);
+
+/**
+ * Semaphore service call handler
+ * Should only be called by global SVC handler.  This takes va_args for the
+ * semaphore service calls and returns the result of the service call.
+ *
+ * @param svc_number    Service call number.  Must be a semaphore service call
+ * @param va_args       Arguments for service call
+ * @returns Return value of service call
+ */
+int semaphore_service_call(uint32_t svc_number, ...);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef KERNEL_STATIC_TASK_H_INCLUDED
+#define KERNEL_STATIC_TASK_H_INCLUDED
+
+#include <stdint.h>
+#include <linker_array.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+
+/* Static task, as defined by DEFINE_STATIC_TASK */
+struct static_task {
+    void                (*fptr)(void);
+    uint8_t             priority;
+    uint32_t            period_us;
+    uint32_t            *stack;
+    uint32_t            stack_words;
+    struct task_ctrl    *task;
+};
+
+/*
+ * Statically define task
+ *
+ * The task control block and stack are placed in .bss, and the task is
+ * started with the scheduler, without any allocation.  Static tasks are
+ * never freed, so a non-periodic static task that ends cannot be restarted.
+ *
+ * DEFINE_STATIC_TASK(sensor_task, 3, 10000, 128);
+ *
+ * @param fn            Task function
+ * @param prio          Task priority
+ * @param period        Task period, in microseconds, or 0 if not periodic
+ * @param words         Stack size, in words
+ */
+#define DEFINE_STATIC_TASK(fn, prio, period, words)                         \
+    static struct task_ctrl _static_task_ctrl_##fn;                         \
+    static uint32_t _static_task_stack_##fn[words]                          \
+        __attribute__((aligned(8)));                                        \
+    const struct static_task _static_task_##fn                              \
+        LINKER_ARRAY_ENTRY(static_tasks) = {                                \
+        .fptr = fn,                                                         \
+        .priority = (prio),                                                 \
+        .period_us = (period),                                              \
+        .stack = _static_task_stack_##fn,                                   \
+        .stack_words = (words),                                             \
+        .task = &_static_task_ctrl_##fn,                                    \
+    };
+
+/* Start all static tasks.  Called by start_sched(). */
+void start_static_tasks(void) __attribute__((section(".kernel")));
+
+#endif
@@ -76,6 +76,22 @@ enum service_calls {
     SVC_RELEASE,
     SVC_REGISTER_TASK,
     SVC_TASK_SWITCH,
+    SVC_SLEEP,
+    SVC_TASK_STATS,
+    SVC_SEM_WAIT,
+    SVC_SEM_POST,
+    SVC_EVENT_WAIT,
+    SVC_EVENT_SET,
+    SVC_MSG_QUEUE_SEND,
+    SVC_MSG_QUEUE_RECEIVE,
+    SVC_RWLOCK_READ_ACQUIRE,
+    SVC_RWLOCK_READ_RELEASE,
+    SVC_RWLOCK_WRITE_ACQUIRE,
+    SVC_RWLOCK_WRITE_RELEASE,
+    SVC_HRTIMER_START,
+    SVC_HRTIMER_CANCEL,
+    SVC_TASKLET_START,
+    SVC_TASKLET_STOP,
 };
 
 #endif
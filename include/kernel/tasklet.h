@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef KERNEL_TASKLET_H_INCLUDED
+#define KERNEL_TASKLET_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+
+/*
+ * Tasklets
+ *
+ * Lightweight one-shot or periodic jobs, for small units of work which
+ * don't warrant a task and its stack.  Tasklets are released on system
+ * ticks, like periodic tasks, and run to completion, one at a time, in
+ * the tasklet task, on its stack.  A tasklet must not block for long, as
+ * it delays every other tasklet.
+ *
+ * struct tasklet is owned by the caller, and is usually static.  Context
+ * is passed by embedding the tasklet in a larger struct, and using
+ * container_of() in the function.
+ */
+struct tasklet {
+    void            (*func)(struct tasklet *tasklet);
+    uint32_t        period_us;      /* 0 for one-shot */
+    uint32_t        overruns;       /* releases missed while still pending */
+
+    /* Internal */
+    struct list     tasklet_queue;  /* Waiting for release */
+    uint32_t        ticks_until_release;
+    uint32_t        period;         /* in ticks */
+    struct tasklet  *next;          /* Released, waiting to run */
+    uint32_t        pending;
+};
+
+/* Priority of the tasklet task, just below the kernel worker */
+#define TASKLET_PRIORITY    (CONFIG_SCHED_PRIORITIES - 2)
+
+/*
+ * Statically initialize tasklet
+ *
+ * struct tasklet tasklet = INIT_TASKLET(tasklet, handler, 1000);
+ *
+ * @param name  Name of tasklet being initialized
+ * @param fn    Function to run, passed the tasklet
+ * @param us    Period in microseconds, 0 for one-shot
+ */
+#define INIT_TASKLET(name, fn, us) {                    \
+    .func = (fn),                                       \
+    .period_us = (us),                                  \
+    .overruns = 0,                                      \
+    .tasklet_queue = INIT_LIST((name).tasklet_queue),   \
+    .ticks_until_release = 0,                           \
+    .period = 0,                                        \
+    .next = NULL,                                       \
+    .pending = 0,                                       \
+}
+
+/*
+ * Dynamically initialize tasklet
+ *
+ * @param tasklet   Tasklet to initialize
+ * @param fn        Function to run, passed the tasklet
+ * @param period_us Period in microseconds, 0 for one-shot
+ */
+static inline void init_tasklet(struct tasklet *tasklet,
+                                void (*fn)(struct tasklet *tasklet),
+                                uint32_t period_us) {
+    tasklet->func = fn;
+    tasklet->period_us = period_us;
+    tasklet->overruns = 0;
+    list_init(&tasklet->tasklet_queue);
+    tasklet->ticks_until_release = 0;
+    tasklet->period = 0;
+    tasklet->next = NULL;
+    tasklet->pending = 0;
+}
+
+#ifdef CONFIG_TASKLETS
+
+/*
+ * Start tasklet
+ *
+ * The tasklet is first released after delay_us, and then every period_us,
+ * if it is periodic.  Both are rounded up to whole system ticks.  A
+ * started tasklet is restarted.
+ *
+ * A periodic tasklet still waiting to run at its next release counts an
+ * overrun, and is not queued twice.
+ *
+ * Safe from interrupt context and from tasks.  Never blocks.
+ *
+ * @param tasklet   Tasklet to start
+ * @param delay_us  Microseconds until first release
+ * @returns 1 if the tasklet was already started, 0 otherwise
+ */
+int tasklet_start(struct tasklet *tasklet, uint32_t delay_us);
+
+/*
+ * Stop tasklet
+ *
+ * The tasklet is not released again, though a release already waiting to
+ * run still runs.  Safe from interrupt context and from tasks.
+ *
+ * @param tasklet   Tasklet to stop
+ * @returns 1 if the tasklet was started, 0 otherwise
+ */
+int tasklet_stop(struct tasklet *tasklet);
+
+int tasklet_service_call(uint32_t svc_number, ...);
+
+/* Tasklet task, started with the scheduler */
+void tasklet_task(void) __attribute__((section(".kernel")));
+
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef KERNEL_TRACE_H_INCLUDED
+#define KERNEL_TRACE_H_INCLUDED
+
+#include <stdint.h>
+
+/*
+ * Scheduler event trace
+ *
+ * With CONFIG_SCHED_TRACE, scheduler events are recorded with a timestamp
+ * into a RAM ring of CONFIG_SCHED_TRACE_EVENTS events, overwriting the
+ * oldest events once full.  Without it, recording compiles away.
+ *
+ * Events are only recorded from kernel and interrupt context, where they
+ * can't preempt each other, so no locking is required.
+ *
+ * ARMv7-M vectors each interrupt directly to its handler, so there is no
+ * common entry point to record interrupts from.  Each interrupt handler
+ * records its own TRACE_ISR_ENTER and TRACE_ISR_EXIT events instead.  At
+ * present these are the SysTick, high resolution timer, and USB device
+ * handlers, which are all of the interrupt handlers in the tree.  A new
+ * handler which does not record them appears in the trace as time spent
+ * in whichever task it interrupted.  Fault handlers are fatal, and are not
+ * traced.
+ */
+
+enum trace_type {
+    TRACE_SWITCH = 1,       /* arg: pid of task switched to */
+    TRACE_SVC,              /* arg: SVC number */
+    TRACE_ISR_ENTER,        /* arg: exception number */
+    TRACE_ISR_EXIT,         /* arg: exception number */
+    TRACE_MUTEX_BLOCK,      /* arg: address of mutex blocked on */
+    TRACE_MUTEX_UNBLOCK,    /* arg: address of mutex handed to a waiter */
+    TRACE_RELEASE,          /* arg: pid of periodic task released */
+    TRACE_OVERRUN,          /* arg: pid of periodic task still running */
+};
+
+/* Recorded event, exported as is, in little endian */
+struct trace_event {
+    uint32_t    timestamp;  /* in arch_trace_timestamp() counts */
+    uint32_t    arg;        /* depends on type */
+    uint16_t    pid;        /* current task, 0 if none */
+    uint8_t     type;       /* enum trace_type */
+    uint8_t     reserved;
+};
+
+/*
+ * Exported trace, as written by the trace shell command and read by
+ * tools/trace_decode.py.  The header is followed by count events,
+ * oldest first.
+ */
+#define TRACE_MAGIC     "F4TR"
+#define TRACE_VERSION   1
+
+struct trace_header {
+    char        magic[4];       /* TRACE_MAGIC, without NUL */
+    uint8_t     version;        /* TRACE_VERSION */
+    uint8_t     event_size;     /* sizeof(struct trace_event) */
+    uint16_t    reserved;
+    uint32_t    timestamp_hz;   /* Frequency of event timestamps */
+    uint32_t    count;          /* Number of events */
+};
+
+#ifdef CONFIG_SCHED_TRACE
+
+/**
+ * Record trace event
+ *
+ * Must only be called from kernel or interrupt context.
+ *
+ * @param type  Event type, from enum trace_type
+ * @param arg   Event argument, depending on type
+ */
+void trace_record(uint8_t type, uint32_t arg) __attribute__((section(".kernel")));
+
+/**
+ * Clear the trace, and start recording
+ *
+ * Recording is started at boot.
+ */
+void trace_start(void);
+
+/**
+ * Stop recording
+ *
+ * Once stopped, the recorded events may be read without being overwritten.
+ */
+void trace_stop(void);
+
+/**
+ * Get number of recorded events available to read
+ *
+ * @returns Number of events, at most CONFIG_SCHED_TRACE_EVENTS
+ */
+uint32_t trace_count(void);
+
+/**
+ * Read recorded events
+ *
+ * Recording should be stopped while reading, or events may be overwritten
+ * while being read.
+ *
+ * @param events    Array to copy events to
+ * @param start     Index of first event to copy, with 0 the oldest event
+ * @param max       Number of entries in events
+ * @returns Number of events copied
+ */
+int trace_read(struct trace_event *events, uint32_t start, int max);
+
+/**
+ * Get current trace timestamp
+ *
+ * Provided by the arch.
+ *
+ * @returns Free running timestamp, in CONFIG_SYS_CLOCK counts
+ */
+uint32_t arch_trace_timestamp(void);
+
+#else
+
+static inline void trace_record(uint8_t type, uint32_t arg) {}
+
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef KERNEL_WORKQUEUE_H_INCLUDED
+#define KERNEL_WORKQUEUE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Deferred work
+ *
+ * Interrupt handlers should do only what must happen at interrupt level,
+ * and queue the rest as work.  Work runs in order, one item at a time, in
+ * the kernel worker task, which runs at the highest task priority.
+ *
+ * With CONFIG_SCHED_POLICY_EDF, periodic tasks run ahead of any priority,
+ * so the worker instead has an immediate deadline, set each time it is
+ * woken.  It runs ahead of periodic tasks whose deadlines are still to
+ * come, but behind any that have overrun their deadline.
+ *
+ * struct work is owned by the caller, and is usually static.  It may be
+ * requeued once its function has started, including from that function.
+ */
+struct work {
+    void            (*func)(struct work *work);
+    struct work     *next;
+    uint32_t        pending;
+};
+
+/* Priority of the kernel worker task */
+#define WORKQUEUE_PRIORITY  (CONFIG_SCHED_PRIORITIES - 1)
+
+/*
+ * Statically initialize work
+ *
+ * struct work work = INIT_WORK(handler);
+ *
+ * @param fn    Function to run, passed the work item
+ */
+#define INIT_WORK(fn) {     \
+    .func = (fn),           \
+    .next = NULL,           \
+    .pending = 0,           \
+}
+
+/*
+ * Dynamically initialize work
+ *
+ * @param work  Work to initialize
+ * @param fn    Function to run, passed the work item
+ */
+static inline void init_work(struct work *work,
+                             void (*fn)(struct work *work)) {
+    work->func = fn;
+    work->next = NULL;
+    work->pending = 0;
+}
+
+/*
+ * Queue work for the kernel worker task
+ *
+ * Safe from interrupt context and from tasks.  Never blocks.
+ *
+ * Work queued from interrupt context starts once interrupt handlers return.
+ *
+ * @param work  Work to queue
+ * @returns 0 if queued, 1 if it was already pending
+ */
+int queue_work(struct work *work);
+
+/* Kernel worker task, started with the scheduler */
+void workqueue_task(void) __attribute__((section(".kernel")));
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RING_H_INCLUDED
+#define RING_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic.h>
+
+/*
+ * Single-producer/single-consumer ring buffer
+ *
+ * A lock-free byte ring, safe for exactly one writer and one reader at a
+ * time, in any combination of tasks and interrupt handlers.  Neither side
+ * ever blocks or disables interrupts.
+ *
+ * head and tail are free-running byte counts, masked into buf on access,
+ * so size must be a power of two, and the full size is usable.  Only the
+ * producer advances head, and only the consumer advances tail.
+ *
+ * Multiple producers or consumers must serialize among themselves.
+ */
+struct ring {
+    uint8_t             *buf;
+    uint32_t            size;
+    volatile uint32_t   head;   /* Total bytes written */
+    volatile uint32_t   tail;   /* Total bytes read */
+};
+
+/*
+ * Statically initialize ring
+ *
+ * @param buffer    Storage for the ring
+ * @param len       Size of buffer, in bytes.  Must be a power of two.
+ */
+#define INIT_RING(buffer, len) {    \
+    .buf = (buffer),                \
+    .size = (len),                  \
+    .head = 0,                      \
+    .tail = 0,                      \
+}
+
+/*
+ * Statically define ring, with its storage
+ *
+ * Fails to compile if len is not a power of two.
+ *
+ * @param name  Name of ring
+ * @param len   Size of ring, in bytes
+ */
+#define DEFINE_RING(name, len)                                          \
+    typedef char name##_size_is_power_of_two[                           \
+        ((len) & ((len) - 1)) ? -1 : 1];                                \
+    static uint8_t name##_storage[len];                                 \
+    struct ring name = INIT_RING(name##_storage, len)
+
+/*
+ * Dynamically initialize ring
+ *
+ * @param ring      Ring to initialize
+ * @param buffer    Storage for the ring
+ * @param len       Size of buffer, in bytes
+ * @returns 0 on success, -1 if len is not a power of two
+ */
+int init_ring(struct ring *ring, uint8_t *buffer, uint32_t len);
+
+/* Bytes available to the consumer */
+static inline uint32_t ring_used(struct ring *ring) {
+    return ring->head - ring->tail;
+}
+
+/* Bytes available to the producer */
+static inline uint32_t ring_space(struct ring *ring) {
+    return ring->size - ring_used(ring);
+}
+
+static inline int ring_empty(struct ring *ring) {
+    return ring->head == ring->tail;
+}
+
+static inline int ring_full(struct ring *ring) {
+    return ring_used(ring) == ring->size;
+}
+
+/*
+ * Write to ring
+ *
+ * Copies as much of data as fits, and never blocks.  Producer only.
+ *
+ * @param ring  Ring to write to
+ * @param data  Data to write
+ * @param len   Bytes of data
+ * @returns Bytes written
+ */
+size_t ring_write(struct ring *ring, const void *data, size_t len);
+
+/*
+ * Read from ring
+ *
+ * Copies up to len available bytes, and never blocks.  Consumer only.
+ *
+ * @param ring  Ring to read from
+ * @param data  Buffer to read into
+ * @param len   Size of data
+ * @returns Bytes read
+ */
+size_t ring_read(struct ring *ring, void *data, size_t len);
+
+/*
+ * Zero-copy write
+ *
+ * ring_write_peek returns the largest free region of the ring that is
+ * contiguous in memory.  The producer fills some or all of it in place,
+ * then publishes what it wrote with ring_write_commit.  A write that wraps
+ * the end of the buffer takes two peek/commit rounds.
+ *
+ * @param ring  Ring to write to
+ * @param ptr   Set to the start of the free region
+ * @returns Size of the free region, in bytes
+ */
+size_t ring_write_peek(struct ring *ring, uint8_t **ptr);
+
+/*
+ * Publish zero-copy write
+ *
+ * @param ring  Ring written to
+ * @param len   Bytes written, no more than the last ring_write_peek returned
+ */
+void ring_write_commit(struct ring *ring, size_t len);
+
+/*
+ * Zero-copy read
+ *
+ * ring_read_peek returns the largest region of available data that is
+ * contiguous in memory.  The consumer uses it in place, then releases what
+ * it consumed with ring_read_commit.
+ *
+ * @param ring  Ring to read from
+ * @param ptr   Set to the start of the available data
+ * @returns Size of the available region, in bytes
+ */
+size_t ring_read_peek(struct ring *ring, uint8_t **ptr);
+
+/*
+ * Release zero-copy read
+ *
+ * @param ring  Ring read from
+ * @param len   Bytes consumed, no more than the last ring_read_peek returned
+ */
+void ring_read_commit(struct ring *ring, size_t len);
+
+/* Drop all available data.  Consumer only. */
+static inline void ring_discard(struct ring *ring) {
+    ring_read_commit(ring, ring_used(ring));
+}
+
+#endif
@@ -27,6 +27,16 @@
 
 extern volatile uint32_t system_ticks;
 
+#define NSEC_PER_SEC        1000000000
+
+/* Time since boot, unaffected by anything but the passage of time */
+#define CLOCK_MONOTONIC     1
+
+struct timespec {
+    uint32_t    tv_sec;
+    uint32_t    tv_nsec;
+};
+
 /* Microsecond sleep.  Max precision is system tick period (1/CONFIG_SYSTICK_FREQ). */
 int usleep(uint32_t usecs);
 
@@ -34,8 +44,34 @@ int usleep(uint32_t usecs);
  * Time since start time in us.
  *
  * start_time of 0 will indicate us since system boot.
- * Max precision is system tick period (1/CONFIG_SYSTICK_FREQ).
+ * Resolves time within a system tick where the arch supports it.
  */
 uint64_t system_time(uint64_t start_time);
 
+/*
+ * Monotonic time since boot in ns.
+ *
+ * Combines the 64-bit system tick count with the position within the
+ * current tick, so it resolves time within a system tick where the arch
+ * supports it.  May be called from any context, and never blocks.
+ */
+uint64_t clock_monotonic_ns(void);
+
+/*
+ * Get time of clock_id
+ *
+ * @param clock_id  Clock to read.  Only CLOCK_MONOTONIC is supported.
+ * @param tp        Time, filled on success
+ * @returns 0 on success, negative on error
+ */
+int clock_gettime(int clock_id, struct timespec *tp);
+
+/*
+ * Advance system time by ticks system ticks
+ *
+ * Only to be called by the scheduler, from the system tick or with
+ * interrupts masked.
+ */
+void clock_advance(uint32_t ticks);
+
 #endif
@@ -23,7 +23,8 @@
 #include <string.h>
 #include <kernel/collection.h>
 #include <kernel/fault.h>
-#include <kernel/reentrant_mutex.h>
+#include <kernel/rwlock.h>
+#include <kernel/sched.h>
 
 /**
  * Determine if iteration is in progress
@@ -43,19 +44,59 @@ static int collection_iterating(struct collection *c) {
     return iterating;
 }
 
+/**
+ * Lock collection for lookup
+ *
+ * Shared with other lookups, unless the current task already holds the
+ * collection exclusively.
+ *
+ * @param c collection to lock
+ * @returns 1 if the lock was taken, and must be passed to
+ *          collection_read_unlock(), 0 if it was already held
+ */
+static int collection_read_lock(struct collection *c) {
+    /* Only this task could have set held_by to itself */
+    if (c->held_by == curr_task) {
+        return 0;
+    }
+
+    read_acquire(&c->lock);
+    return 1;
+}
+
+static void collection_read_unlock(struct collection *c, int locked) {
+    if (locked) {
+        read_release(&c->lock);
+    }
+}
+
 void collection_lock(struct collection *c) {
     WARN_ON(!c);
 
-    if (c) {
-        reentrant_acquire(&c->lock);
+    if (!c) {
+        return;
+    }
+
+    if (c->held_by != curr_task) {
+        write_acquire(&c->lock);
+        c->held_by = curr_task;
     }
+
+    c->count++;
 }
 
 void collection_unlock(struct collection *c) {
     WARN_ON(!c);
 
-    if (c) {
-        reentrant_release(&c->lock);
+    if (!c) {
+        return;
+    }
+
+    WARN_ON(c->held_by != curr_task);
+
+    if (!--c->count) {
+        c->held_by = NULL;
+        write_release(&c->lock);
     }
 }
 
@@ -134,12 +175,13 @@ int collection_del(struct collection *c, struct obj *o) {
 struct obj *collection_get_by_name(struct collection *c, const char *name) {
     struct obj *ret = NULL;
     struct obj *curr;
+    int locked;
 
     if (!name || !c) {
         return NULL;
     }
 
-    collection_lock(c);
+    locked = collection_read_lock(c);
     list_for_each_entry(curr, &c->list, list) {
         if(!strcmp(curr->name, name)) {
             ret = curr;
@@ -148,6 +190,6 @@ struct obj *collection_get_by_name(struct collection *c, const char *name) {
     }
 
 out:
-    collection_unlock(c);
+    collection_read_unlock(c, locked);
     return ret;
 }
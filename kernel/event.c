@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <list.h>
+#include <kernel/event.h>
+#include <kernel/fault.h>
+#include <kernel/sched.h>
+
+static int svc_event_wait(struct event_group *group, uint32_t timeout_us) __attribute__((section(".kernel")));
+static task_t *set(struct event_group *group, uint32_t flags) __attribute__((section(".kernel")));
+
+static int satisfied(uint32_t group_flags, uint32_t flags, uint8_t mode) {
+    if (mode & EVENT_WAIT_ALL) {
+        return (group_flags & flags) == flags;
+    }
+
+    return !!(group_flags & flags);
+}
+
+/*
+ * Requested flags and mode are passed in curr_task->wait_data.  The result
+ * is returned in curr_task->wait_data.status, and the received flags in
+ * curr_task->wait_data.flags.
+ */
+static int svc_event_wait(struct event_group *group, uint32_t timeout_us) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+
+    if (satisfied(group->flags, wait->flags, wait->mode)) {
+        uint32_t requested = wait->flags;
+
+        wait->flags = group->flags;
+        wait->status = 0;
+
+        if (wait->mode & EVENT_WAIT_CLEAR) {
+            group->flags &= ~requested;
+        }
+
+        return 0;
+    }
+
+    if (!timeout_us) {
+        wait->status = -1;
+        return 0;
+    }
+
+    /* Woken by set(), once the wait is satisfied */
+    task_wait(&group->waiters, timeout_us);
+
+    return 0;
+}
+
+/* Returns the highest priority task woken, if any */
+static task_t *set(struct event_group *group, uint32_t flags) {
+    struct list *element = group->waiters.next;
+    uint32_t clear = 0;
+    task_t *woken = NULL;
+
+    group->flags |= flags;
+
+    while (element != &group->waiters) {
+        task_t *waiter = list_entry(element, task_t, wait_data.wait_list);
+        struct task_wait_data *wait = &waiter->wait_data;
+        uint32_t requested = wait->flags;
+
+        /* Waking removes waiter from the list */
+        element = element->next;
+
+        if (!satisfied(group->flags, requested, wait->mode)) {
+            continue;
+        }
+
+        /* Every waiter woken sees the flags before any are cleared */
+        wait->flags = group->flags;
+
+        if (wait->mode & EVENT_WAIT_CLEAR) {
+            clear |= requested;
+        }
+
+        task_wait_wake(waiter);
+
+        if (task_compare(waiter, woken) > 0) {
+            woken = waiter;
+        }
+    }
+
+    group->flags &= ~clear;
+
+    return woken;
+}
+
+int event_wait(struct event_group *group, uint32_t flags, uint8_t mode,
+               uint32_t timeout_us, uint32_t *received) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+
+    PANIC_ON(!arch_svc_legal());
+
+    wait->flags = flags;
+    wait->mode = mode;
+
+    /* Nothing else can set flags before task switching, so don't block */
+    if (!task_switching) {
+        svc_event_wait(group, 0);
+    }
+    else {
+        SVC_ARG2(SVC_EVENT_WAIT, group, timeout_us);
+    }
+
+    if (!wait->status && received) {
+        *received = wait->flags;
+    }
+
+    return wait->status;
+}
+
+void event_set(struct event_group *group, uint32_t flags) {
+    if (task_switching && arch_svc_legal()) {
+        SVC_ARG2(SVC_EVENT_SET, group, flags);
+    }
+    else {
+        /*
+         * Interrupt context, or before task switching.  Interrupts do not
+         * preempt service calls, so the group can be updated directly.
+         * From an interrupt, the switch is pended until handlers return.
+         */
+        task_t *woken = set(group, flags);
+
+        if (task_switching && woken && task_compare(woken, curr_task) > 0) {
+            task_switch(NULL);
+        }
+    }
+}
+
+void event_clear(struct event_group *group, uint32_t flags) {
+    /* Clearing never wakes a waiter, so no service call is needed */
+    atomic_and(&group->flags, ~flags);
+}
+
+int event_service_call(uint32_t svc_number, ...) {
+    int ret = 0;
+    va_list ap;
+    va_start(ap, svc_number);
+
+    switch (svc_number) {
+        case SVC_EVENT_WAIT: {
+            struct event_group *group = va_arg(ap, struct event_group *);
+            uint32_t timeout_us = va_arg(ap, uint32_t);
+            ret = svc_event_wait(group, timeout_us);
+            break;
+        }
+        case SVC_EVENT_SET: {
+            struct event_group *group = va_arg(ap, struct event_group *);
+            uint32_t flags = va_arg(ap, uint32_t);
+            task_t *woken = set(group, flags);
+
+            if (woken && task_compare(woken, curr_task) > 0) {
+                task_switch(NULL);
+            }
+            break;
+        }
+        default:
+            panic_print("Unknown SVC: %d", svc_number);
+            break;
+    }
+
+    va_end(ap);
+
+    return ret;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <list.h>
+#include <time.h>
+#include <kernel/fault.h>
+#include <kernel/hrtimer.h>
+#include <kernel/sched.h>
+#include <kernel/semaphore.h>
+#include <kernel/svc.h>
+
+/*
+ * Longest delay programmed into the arch timer.  Later expirations are
+ * reached in steps, so the arch timer never needs to count further than
+ * this.
+ */
+#define HRTIMER_MAX_PROGRAM_NS  (NSEC_PER_SEC)
+
+/* Pending timers, earliest expiration first */
+static struct list hrtimers = INIT_LIST(hrtimers);
+
+static int start(struct hrtimer *timer, uint32_t delay_ns) __attribute__((section(".kernel")));
+static int cancel(struct hrtimer *timer) __attribute__((section(".kernel")));
+static void program(void) __attribute__((section(".kernel")));
+
+/* Program the arch timer for the earliest pending timer */
+static void program(void) {
+    struct hrtimer *first;
+    uint64_t now;
+    int64_t delay;
+
+    if (list_empty(&hrtimers)) {
+        arch_hrtimer_stop();
+        return;
+    }
+
+    first = list_entry(hrtimers.next, struct hrtimer, list);
+    now = clock_monotonic_ns();
+    delay = first->expires - now;
+
+    if (delay < 0) {
+        delay = 0;
+    }
+    else if (delay > HRTIMER_MAX_PROGRAM_NS) {
+        delay = HRTIMER_MAX_PROGRAM_NS;
+    }
+
+    arch_hrtimer_program(delay);
+}
+
+static int cancel(struct hrtimer *timer) {
+    int was_active = timer->active;
+
+    if (was_active) {
+        int first = hrtimers.next == &timer->list;
+
+        list_remove(&timer->list);
+        timer->active = 0;
+
+        /* Only the earliest expiration is programmed */
+        if (first) {
+            program();
+        }
+    }
+
+    return was_active;
+}
+
+static int start(struct hrtimer *timer, uint32_t delay_ns) {
+    struct list *element;
+    int was_active;
+
+    /* Don't reprogram for the removal, it happens below if needed */
+    was_active = timer->active;
+    if (was_active) {
+        list_remove(&timer->list);
+    }
+
+    timer->expires = clock_monotonic_ns() + delay_ns;
+    timer->active = 1;
+
+    /* Insert after all timers expiring at or before this one */
+    list_for_each(element, &hrtimers) {
+        struct hrtimer *curr = list_entry(element, struct hrtimer, list);
+
+        if ((int64_t) (curr->expires - timer->expires) > 0) {
+            break;
+        }
+    }
+
+    list_insert_before(&timer->list, element);
+
+    program();
+
+    return was_active;
+}
+
+int hrtimer_start(struct hrtimer *timer, uint32_t delay_ns) {
+    if (task_switching && arch_svc_legal()) {
+        return SVC_ARG2(SVC_HRTIMER_START, timer, delay_ns);
+    }
+
+    /*
+     * Interrupt context, or before task switching.  Interrupts do not
+     * preempt service calls, or each other, so the list can be updated
+     * directly.
+     */
+    return start(timer, delay_ns);
+}
+
+int hrtimer_cancel(struct hrtimer *timer) {
+    if (task_switching && arch_svc_legal()) {
+        return SVC_ARG(SVC_HRTIMER_CANCEL, timer);
+    }
+
+    return cancel(timer);
+}
+
+void hrtimer_interrupt(void) {
+    uint64_t now = clock_monotonic_ns();
+
+    while (!list_empty(&hrtimers)) {
+        struct hrtimer *timer = list_entry(hrtimers.next, struct hrtimer,
+                                           list);
+
+        if ((int64_t) (timer->expires - now) > 0) {
+            break;
+        }
+
+        list_remove(&timer->list);
+        timer->active = 0;
+
+        /* May restart the timer, which reprograms the arch timer */
+        timer->func(timer);
+    }
+
+    program();
+}
+
+struct hrtimer_sleep {
+    struct hrtimer      timer;
+    struct semaphore    done;
+};
+
+static void hrtimer_wake(struct hrtimer *timer) {
+    struct hrtimer_sleep *sleep = container_of(timer, struct hrtimer_sleep,
+                                               timer);
+
+    sem_post(&sleep->done);
+}
+
+int hrtimer_usleep(uint32_t usecs) {
+    struct hrtimer_sleep sleep;
+
+    if (!usecs) {
+        return 0;
+    }
+
+    /*
+     * Waiting on the semaphore requires task context, and the delay must
+     * fit in the timer.
+     */
+    if (!task_switching || !arch_svc_legal() || usecs > UINT32_MAX / 1000) {
+        return usleep(usecs);
+    }
+
+    init_hrtimer(&sleep.timer, hrtimer_wake);
+    init_semaphore(&sleep.done, 0);
+
+    hrtimer_start(&sleep.timer, usecs * 1000);
+
+    return sem_wait(&sleep.done, TIMEOUT_FOREVER);
+}
+
+int hrtimer_service_call(uint32_t svc_number, ...) {
+    int ret = 0;
+    va_list ap;
+    va_start(ap, svc_number);
+
+    switch (svc_number) {
+        case SVC_HRTIMER_START: {
+            struct hrtimer *timer = va_arg(ap, struct hrtimer *);
+            uint32_t delay_ns = va_arg(ap, uint32_t);
+            ret = start(timer, delay_ns);
+            break;
+        }
+        case SVC_HRTIMER_CANCEL: {
+            struct hrtimer *timer = va_arg(ap, struct hrtimer *);
+            ret = cancel(timer);
+            break;
+        }
+        default:
+            panic_print("Unknown SVC: %d", svc_number);
+            break;
+    }
+
+    va_end(ap);
+
+    return ret;
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <list.h>
+#include <kernel/fault.h>
+#include <kernel/msg_queue.h>
+#include <kernel/sched.h>
+
+static int put(struct msg_queue *queue, const void *msg, task_t **woken) __attribute__((section(".kernel")));
+static int get(struct msg_queue *queue, void *msg, task_t **woken) __attribute__((section(".kernel")));
+static int svc_msg_queue_send(struct msg_queue *queue, uint32_t timeout_us) __attribute__((section(".kernel")));
+static int svc_msg_queue_receive(struct msg_queue *queue, uint32_t timeout_us) __attribute__((section(".kernel")));
+
+static uint8_t *slot(struct msg_queue *queue, uint32_t index) {
+    return queue->buffer + (index % queue->capacity) * queue->msg_size;
+}
+
+static task_t *first_waiter(struct list *waiters) {
+    return list_entry(waiters->next, task_t, wait_data.wait_list);
+}
+
+/*
+ * Add message to queue, or hand it to a blocked receiver
+ *
+ * @param queue Queue to send to
+ * @param msg   Message to send
+ * @param woken Set to the task woken, if any
+ * @returns 0 on success, negative if the queue is full
+ */
+static int put(struct msg_queue *queue, const void *msg, task_t **woken) {
+    *woken = NULL;
+
+    /* Receivers only wait on an empty queue */
+    if (!list_empty(&queue->receive_waiters)) {
+        task_t *receiver = first_waiter(&queue->receive_waiters);
+
+        memcpy(receiver->wait_data.data, msg, queue->msg_size);
+        task_wait_wake(receiver);
+        *woken = receiver;
+
+        return 0;
+    }
+
+    if (queue->count == queue->capacity) {
+        return -1;
+    }
+
+    memcpy(slot(queue, queue->head + queue->count), msg, queue->msg_size);
+    queue->count++;
+
+    return 0;
+}
+
+/*
+ * Take message from queue, refilling its slot from a blocked sender
+ *
+ * @param queue Queue to receive from
+ * @param msg   Buffer to receive message into
+ * @param woken Set to the task woken, if any
+ * @returns 0 on success, negative if the queue is empty
+ */
+static int get(struct msg_queue *queue, void *msg, task_t **woken) {
+    *woken = NULL;
+
+    if (!queue->count) {
+        return -1;
+    }
+
+    memcpy(msg, slot(queue, queue->head), queue->msg_size);
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+
+    /* Senders only wait on a full queue */
+    if (!list_empty(&queue->send_waiters)) {
+        task_t *sender = first_waiter(&queue->send_waiters);
+
+        memcpy(slot(queue, queue->head + queue->count),
+               sender->wait_data.data, queue->msg_size);
+        queue->count++;
+
+        task_wait_wake(sender);
+        *woken = sender;
+    }
+
+    return 0;
+}
+
+/* Switch to a woken task, if it should preempt us */
+static void preempt(task_t *woken) {
+    if (woken && task_compare(woken, curr_task) > 0) {
+        task_switch(NULL);
+    }
+}
+
+/*
+ * Message is passed in curr_task->wait_data.data.  The result is returned
+ * in curr_task->wait_data.status.
+ */
+static int svc_msg_queue_send(struct msg_queue *queue, uint32_t timeout_us) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+    task_t *woken;
+
+    wait->status = put(queue, wait->data, &woken);
+
+    if (wait->status && timeout_us) {
+        /* Woken by get(), which copies our message into the queue */
+        task_wait(&queue->send_waiters, timeout_us);
+    }
+    else {
+        preempt(woken);
+    }
+
+    return 0;
+}
+
+/*
+ * Buffer is passed in curr_task->wait_data.data.  The result is returned
+ * in curr_task->wait_data.status.
+ */
+static int svc_msg_queue_receive(struct msg_queue *queue,
+                                 uint32_t timeout_us) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+    task_t *woken;
+
+    wait->status = get(queue, wait->data, &woken);
+
+    if (wait->status && timeout_us) {
+        /* Woken by put(), which copies the message into our buffer */
+        task_wait(&queue->receive_waiters, timeout_us);
+    }
+    else {
+        preempt(woken);
+    }
+
+    return 0;
+}
+
+int msg_queue_send(struct msg_queue *queue, const void *msg,
+                   uint32_t timeout_us) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+
+    PANIC_ON(!arch_svc_legal());
+
+    wait->data = (void *) msg;
+
+    /* Nothing else can receive before task switching, so don't block */
+    if (!task_switching) {
+        svc_msg_queue_send(queue, 0);
+    }
+    else {
+        SVC_ARG2(SVC_MSG_QUEUE_SEND, queue, timeout_us);
+    }
+
+    return wait->status;
+}
+
+int msg_queue_receive(struct msg_queue *queue, void *msg,
+                      uint32_t timeout_us) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+
+    PANIC_ON(!arch_svc_legal());
+
+    wait->data = msg;
+
+    /* Nothing else can send before task switching, so don't block */
+    if (!task_switching) {
+        svc_msg_queue_receive(queue, 0);
+    }
+    else {
+        SVC_ARG2(SVC_MSG_QUEUE_RECEIVE, queue, timeout_us);
+    }
+
+    return wait->status;
+}
+
+int msg_queue_post(struct msg_queue *queue, const void *msg) {
+    task_t *woken;
+    int ret;
+
+    if (task_switching && arch_svc_legal()) {
+        return msg_queue_send(queue, msg, 0);
+    }
+
+    /*
+     * Interrupt context, or before task switching.  Interrupts do not
+     * preempt service calls, so the queue can be updated directly.  From an
+     * interrupt, the switch is pended until handlers return.
+     */
+    ret = put(queue, msg, &woken);
+
+    if (task_switching) {
+        preempt(woken);
+    }
+
+    return ret;
+}
+
+int msg_queue_service_call(uint32_t svc_number, ...) {
+    int ret = 0;
+    va_list ap;
+    va_start(ap, svc_number);
+
+    switch (svc_number) {
+        case SVC_MSG_QUEUE_SEND: {
+            struct msg_queue *queue = va_arg(ap, struct msg_queue *);
+            uint32_t timeout_us = va_arg(ap, uint32_t);
+            ret = svc_msg_queue_send(queue, timeout_us);
+            break;
+        }
+        case SVC_MSG_QUEUE_RECEIVE: {
+            struct msg_queue *queue = va_arg(ap, struct msg_queue *);
+            uint32_t timeout_us = va_arg(ap, uint32_t);
+            ret = svc_msg_queue_receive(queue, timeout_us);
+            break;
+        }
+        default:
+            panic_print("Unknown SVC: %d", svc_number);
+            break;
+    }
+
+    va_end(ap);
+
+    return ret;
+}
@@ -20,31 +20,77 @@
  * SOFTWARE.
  */
 
+#include <atomic.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include <list.h>
 #include <kernel/sched.h>
 #include <kernel/fault.h>
+#include <kernel/rwlock.h>
+#include <kernel/trace.h>
 
 #include <kernel/mutex.h>
 
 static void held_mutexes_insert(struct mutex *list[], volatile struct mutex *mutex) __attribute__((section(".kernel")));
 void held_mutexes_remove(struct mutex *list[], volatile struct mutex *mutex) __attribute__((section(".kernel")));
 static void deadlock_check(volatile struct mutex *mut) __attribute__((section(".kernel")));
+static uint8_t inherited_priority(task_t *task) __attribute__((section(".kernel")));
+#ifdef CONFIG_SCHED_POLICY_EDF
+static int inherited_deadline(task_t *task, uint32_t *deadline) __attribute__((section(".kernel")));
+#endif
+void priority_inherit(task_t *task) __attribute__((section(".kernel")));
+
+/*
+ * Take mutex from the calling task, if it is unlocked
+ *
+ * Exceptions clear the exclusive monitor, so a task switch between the load
+ * and store simply causes a retry.
+ */
+static int try_lock(volatile struct mutex *mutex) {
+    do {
+        if (load_link32(&mutex->lock)) {
+            return 0;
+        }
+    } while (store_conditional32(&mutex->lock, (uint32_t) curr_task));
+
+    return 1;
+}
+
+/*
+ * Drop mutex from the calling task, if it is held without contention
+ *
+ * If other tasks have tried to acquire the mutex, the kernel must
+ * release it, in order to hand it off.
+ */
+static int try_unlock(volatile struct mutex *mutex) {
+    do {
+        if (load_link32(&mutex->lock) != (uint32_t) curr_task) {
+            return 0;
+        }
+    } while (store_conditional32(&mutex->lock, 0));
+
+    return 1;
+}
 
 void acquire(volatile struct mutex *mutex) {
     if (!task_switching) {
-        mutex->lock = 1;
-        mutex->held_by = (task_t *) 0x0badf00d;
+        mutex->lock = (uint32_t) curr_task;
         return;
     }
 
-    int success = 0;
-
-    while (!success) {
-        success = SVC_ARG(SVC_ACQUIRE, (void *) mutex);
+    /*
+     * Fast path, no need to enter the kernel if the mutex is free.  The
+     * mutex is recorded as held after it is taken, so svc_acquire() records
+     * it on our behalf if it is contended in between.
+     */
+    if (try_lock(mutex)) {
+        held_mutexes_insert(curr_task->mutex_data.held_mutexes, mutex);
+        return;
     }
+
+    SVC_ARG(SVC_ACQUIRE, (void *) mutex);
 }
 
 /* Acquire mutex, but remove from held mutexes list so that it can be freed. */
@@ -53,67 +99,80 @@ void acquire_for_free(volatile struct mutex *mutex) {
     held_mutexes_remove(curr_task->mutex_data.held_mutexes, mutex);
 }
 
-static int get_lock(volatile struct mutex *mutex) {
-    struct task_mutex_data *curr_task_data = &curr_task->mutex_data;
+/* Make task the owner of mutex, which must be free or handed off */
+static void set_owner(volatile struct mutex *mutex, task_t *task,
+                      uint32_t flags) {
+    struct task_mutex_data *task_data = &task->mutex_data;
 
-    /* TODO: Use a nicer name than this builtin */
-    if (__sync_bool_compare_and_swap(&mutex->lock, 0, 1)) {
-        mutex->held_by = curr_task;
-        held_mutexes_insert(curr_task_data->held_mutexes, mutex);
-        curr_task_data->waiting = NULL;
-        return 1;
-    }
-    else {
-        if (mutex->held_by != NULL) {
-            deadlock_check(mutex);
+    mutex->lock = (uint32_t) task | flags;
+    held_mutexes_insert(task_data->held_mutexes, mutex);
+    task_data->waiting = NULL;
+}
 
-            /* Add to waitlist if higher priority */
-            if (mutex->waiting) {
-                if (task_compare(mutex->waiting, curr_task) < 0) {
-                    mutex->waiting = curr_task;
-                    curr_task_data->waiting = (struct mutex *) mutex;
-                }
-            }
-            else {
-                mutex->waiting = curr_task;
-                curr_task_data->waiting = (struct mutex *) mutex;
-            }
+/* Insert task into mutex wait list, behind waiters of equal or greater priority */
+static void waiters_insert(struct mutex *mutex, task_t *task) {
+    struct list *element;
 
-            return 0;
-        }
-        else {
-            panic_print("Semaphore (0x%x) not available, but held_by unset.", mutex);
+    list_for_each(element, &mutex->waiters) {
+        task_t *waiter = list_entry(element, task_t, mutex_data.wait_list);
+
+        if (task_compare(task, waiter) > 0) {
+            break;
         }
     }
 
-    return 0;
+    list_insert_before(&task->mutex_data.wait_list, element);
+    task->mutex_data.waiting = (struct mutex *) mutex;
 }
 
 void release(volatile struct mutex *mutex) {
     if (!mutex->lock) { /* WTF, don't release an unlocked mutex */
-        mutex->held_by = NULL;
-        mutex->waiting = NULL;
         return;
     }
 
     if (!task_switching) {
         mutex->lock = 0;
-        mutex->held_by = NULL;
+        return;
+    }
+
+    /*
+     * Fast path, no need to enter the kernel if there are no waiters.
+     * Until it is removed, the stale held entry is ignored, as the mutex
+     * no longer names us as owner.
+     */
+    if (try_unlock(mutex)) {
+        held_mutexes_remove(curr_task->mutex_data.held_mutexes, mutex);
         return;
     }
 
     SVC_ARG(SVC_RELEASE, (void *) mutex);
 }
 
+/*
+ * Record mutex in a task's held list, if it is not already there
+ *
+ * The kernel may record a mutex for its owner while the owner is part way
+ * through recording it itself.  Both pick the same first free slot, so the
+ * mutex is never recorded twice.
+ */
 static void held_mutexes_insert(struct mutex *list[], volatile struct mutex *mutex) {
+    int free = -1;
+
     for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
-        if (list[i] == NULL) {
-            list[i] = (struct mutex *) mutex;
+        if (list[i] == mutex) {
             return;
         }
+
+        if (list[i] == NULL && free < 0) {
+            free = i;
+        }
+    }
+
+    if (free < 0) {
+        panic_print("Too many mutexes already held in list (0x%x).", list);
     }
 
-    panic_print("Too many mutexes already held in list (0x%x).", list);
+    list[free] = (struct mutex *) mutex;
 }
 
 void held_mutexes_remove(struct mutex *list[], volatile struct mutex *mutex) {
@@ -127,71 +186,232 @@ void held_mutexes_remove(struct mutex *list[], volatile struct mutex *mutex) {
 }
 
 static void deadlock_check(volatile struct mutex *mut) {
-    struct task_t *task = mut->held_by;
-    struct task_mutex_data *task_data = &task->mutex_data;
+    struct task_t *task = mutex_owner(mut);
 
     if (task == curr_task) {
         panic_print("Task (0x%x) attempted to double acquire mutex 0x%x",
                     curr_task, mut);
     }
 
-    if (task_data->waiting) {
-        for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
-            struct task_mutex_data *curr_task_data = &curr_task->mutex_data;
-            if (curr_task_data->held_mutexes[i] == task_data->waiting) {
-                panic_print("Deadlock!  Task (0x%x) is waiting on mutex 0x%x, "
-                            "but curr_task (0x%x) holds it.", task, task_data->waiting,
-                            curr_task);
+    /*
+     * Follow the chain of owners blocked on other mutexes.  If it leads
+     * back to curr_task, blocking would deadlock.  Since every wait is
+     * checked, the chain never contains a cycle.
+     */
+    while (task->mutex_data.waiting) {
+        struct mutex *waiting = task->mutex_data.waiting;
+
+        if (mutex_owner(waiting) == curr_task) {
+            panic_print("Deadlock!  Task (0x%x) is waiting on mutex 0x%x, "
+                        "but curr_task (0x%x) holds it.", task, waiting,
+                        curr_task);
+        }
+
+        task = mutex_owner(waiting);
+    }
+}
+
+/*
+ * Returns non-zero if mutex, from task's held list, is contended and still
+ * held by task
+ *
+ * A task's held list can briefly hold a mutex it has already released on
+ * the fast path, which may now belong to another task.
+ */
+static int held_contended(task_t *task, struct mutex *mutex) {
+    if (!mutex || !(mutex->lock & MUTEX_CONTENDED)) {
+        return 0;
+    }
+
+    return mutex_owner(mutex) == task;
+}
+
+/*
+ * Highest priority of task and all tasks waiting on mutexes and rwlocks it
+ * holds
+ */
+static uint8_t inherited_priority(task_t *task) {
+    uint8_t priority = task_base_priority(task);
+
+    for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
+        struct mutex *mutex = task->mutex_data.held_mutexes[i];
+        task_t *waiter;
+
+        if (!held_contended(task, mutex)) {
+            continue;
+        }
+
+        /* Not sorted by priority, under EDF */
+        list_for_each_entry(waiter, &mutex->waiters, mutex_data.wait_list) {
+            if (task_priority(waiter) > priority) {
+                priority = task_priority(waiter);
             }
         }
     }
+
+    return rwlock_inherited_priority(task, priority);
+}
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+/*
+ * Earliest deadline of all tasks waiting on mutexes and rwlocks task holds
+ *
+ * Periodic tasks run ahead of all others under EDF, so raising the
+ * priority of a non-periodic owner is not enough to let it run ahead of
+ * other periodic tasks.  The owner must also inherit the deadline of a
+ * periodic waiter.
+ *
+ * Returns 1 and sets deadline if any waiter is scheduled by deadline, 0
+ * otherwise.
+ */
+static int inherited_deadline(task_t *task, uint32_t *deadline) {
+    int found = 0;
+
+    for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
+        struct mutex *mutex = task->mutex_data.held_mutexes[i];
+        task_t *waiter;
+
+        if (!held_contended(task, mutex)) {
+            continue;
+        }
+
+        list_for_each_entry(waiter, &mutex->waiters, mutex_data.wait_list) {
+            uint32_t waiter_deadline;
+
+            if (!task_deadline(waiter, &waiter_deadline)) {
+                continue;
+            }
+
+            if (!found || (int32_t) (waiter_deadline - *deadline) < 0) {
+                *deadline = waiter_deadline;
+                found = 1;
+            }
+        }
+    }
+
+    return rwlock_inherited_deadline(task, found, deadline);
+}
+#endif
+
+/*
+ * If task is itself blocked on a mutex, it is also reordered in the wait
+ * list before the change is propagated to the mutex's owner.
+ */
+void priority_inherit(task_t *task) {
+    while (task) {
+        struct mutex *waiting = task->mutex_data.waiting;
+        uint8_t priority = inherited_priority(task);
+        int changed = priority != task_priority(task);
+
+        task_set_priority(task, priority);
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+        uint32_t deadline = 0;
+        int inherit = inherited_deadline(task, &deadline);
+
+        changed |= task_inherit_deadline(task, inherit, deadline);
+#endif
+
+        if (!changed || !waiting) {
+            return;
+        }
+
+        list_remove(&task->mutex_data.wait_list);
+        waiters_insert(waiting, task);
+
+        task = mutex_owner(waiting);
+    }
 }
 
 void task_mutex_setup(task_t *task) {
     struct task_mutex_data *mut_data = &task->mutex_data;
 
     memset(mut_data->held_mutexes, 0, sizeof(mut_data->held_mutexes));
+    memset(mut_data->held_rwlocks, 0, sizeof(mut_data->held_rwlocks));
     mut_data->waiting = NULL;
+    list_init(&mut_data->wait_list);
 }
 
+/*
+ * Acquire mutex for curr_task
+ *
+ * If the mutex is held, curr_task blocks on its wait list until the mutex
+ * is handed to it by svc_release().  Either way, the task owns the mutex
+ * when it next runs.
+ */
 static int svc_acquire(struct mutex *mutex) {
-    int ret;
-
-    if (get_lock(mutex)) {
-        /* Success */
-        ret = 1;
+    /*
+     * Tasks cannot run while in the kernel, and the exclusive monitor is
+     * cleared on exception return, so the lock may be modified directly.
+     */
+    if (!mutex->lock) {
+        set_owner(mutex, curr_task, 0);
+        return 1;
     }
-    else {
-        /* Failure */
-        ret = 0;
 
-        if (task_runnable(mutex->held_by)
-                && (task_compare(mutex->held_by, curr_task) <= 0)) {
-            task_switch(mutex->held_by);
-        }
-        else {
-            /* If task was not runnable, it was either a period task
-             * between runs, or it recently ended without releasing
-             * the mutex.  In that case, the kernel task will
-             * release the mutex on its next run. */
-            task_switch(NULL);
-        }
+    deadlock_check(mutex);
+
+    /* First waiter, the wait list is not yet valid */
+    if (!(mutex->lock & MUTEX_CONTENDED)) {
+        list_init(&mutex->waiters);
+
+        /* Force the holder to release through the kernel */
+        mutex->lock |= MUTEX_CONTENDED;
     }
 
-    return ret;
+    waiters_insert(mutex, curr_task);
+
+    /*
+     * The owner may have been preempted after taking the mutex on the fast
+     * path, but before recording it as held.  Record it now, so that the
+     * owner inherits from its waiters.
+     */
+    held_mutexes_insert(mutex_owner(mutex)->mutex_data.held_mutexes, mutex);
+
+    /* Boost the owner, and anything it is waiting on, to our priority */
+    priority_inherit(mutex_owner(mutex));
+
+    trace_record(TRACE_MUTEX_BLOCK, (uint32_t) mutex);
+    task_block(curr_task, TIMEOUT_FOREVER);
+    task_switch(NULL);
+
+    return 1;
 }
 
+/* Release mutex, handing it directly to the highest priority waiter */
 static void svc_release(struct mutex *mutex) {
-    mutex->lock = 0;
-    mutex->held_by = NULL;
-    held_mutexes_remove(curr_task->mutex_data.held_mutexes, mutex);
+    task_t *owner = mutex_owner(mutex);
+    task_t *waiter;
+    uint32_t flags = MUTEX_CONTENDED;
+
+    held_mutexes_remove(owner->mutex_data.held_mutexes, mutex);
+
+    if (!(mutex->lock & MUTEX_CONTENDED)) {
+        mutex->lock = 0;
+        return;
+    }
+
+    waiter = list_entry(list_pop_head(&mutex->waiters), task_t,
+                        mutex_data.wait_list);
+
+    /* Last waiter, the holder may once again release without the kernel */
+    if (list_empty(&mutex->waiters)) {
+        flags = 0;
+    }
+
+    set_owner(mutex, waiter, flags);
+    task_wake(waiter);
+    trace_record(TRACE_MUTEX_UNBLOCK, (uint32_t) mutex);
 
-    if (mutex->waiting
-            && (task_compare(mutex->waiting, curr_task) >= 0)) {
-        task_t *task = mutex->waiting;
-        mutex->waiting = NULL;
+    /*
+     * The old owner no longer inherits from this mutex's waiters, while
+     * the new owner now does.
+     */
+    priority_inherit(owner);
+    priority_inherit(waiter);
 
-        task_switch(task);
+    if (task_compare(waiter, curr_task) > 0) {
+        task_switch(NULL);
     }
 }
 
@@ -0,0 +1,568 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <atomic.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <list.h>
+#include <kernel/fault.h>
+#include <kernel/mutex.h>
+#include <kernel/rwlock.h>
+#include <kernel/sched.h>
+
+static void svc_read_acquire(struct rwlock *rw) __attribute__((section(".kernel")));
+static void svc_read_release(struct rwlock *rw) __attribute__((section(".kernel")));
+static void svc_write_acquire(struct rwlock *rw) __attribute__((section(".kernel")));
+static void svc_write_release(struct rwlock *rw) __attribute__((section(".kernel")));
+static void inherit_holders(struct rwlock *rw) __attribute__((section(".kernel")));
+
+static inline volatile uint32_t *state_word(struct rwlock *rw) {
+    return (volatile uint32_t *) &rw->state;
+}
+
+static inline volatile uint32_t *slot_word(struct rwlock *rw, int i) {
+    return (volatile uint32_t *) &rw->readers[i];
+}
+
+/* Task named by a reader slot, or NULL if it is free */
+static inline task_t *slot_task(uint32_t slot) {
+    return (task_t *) (slot & ~RWLOCK_READER_KERNEL);
+}
+
+/*
+ * Claim a free reader slot for the calling task
+ *
+ * Exceptions clear the exclusive monitor, so a task switch between the load
+ * and store simply causes a retry.
+ *
+ * Returns non-zero if a slot was claimed.
+ */
+static int claim_slot(struct rwlock *rw) {
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        uint32_t slot;
+
+        do {
+            slot = load_link32(slot_word(rw, i));
+        } while (!slot && store_conditional32(slot_word(rw, i),
+                                              (uint32_t) curr_task));
+
+        if (!slot) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Clear the calling task's reader slot, unless the kernel has marked it
+ *
+ * Returns non-zero if the slot was cleared.
+ */
+static int clear_slot(struct rwlock *rw) {
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        uint32_t slot;
+
+        do {
+            slot = load_link32(slot_word(rw, i));
+            if (slot != (uint32_t) curr_task) {
+                break;
+            }
+        } while (store_conditional32(slot_word(rw, i), 0));
+
+        if (slot == (uint32_t) curr_task) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Index of task's reader slot, marked or not, or -1 if it has none
+ *
+ * Tasks cannot run while in the kernel, and the exclusive monitor is
+ * cleared on exception return, so from here on the lock may be read and
+ * modified directly.
+ */
+static int find_slot(struct rwlock *rw, task_t *task) {
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        if (rw->readers[i] && slot_task(rw->readers[i]) == task) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Index of a free reader slot, or -1 if all are taken */
+static int free_slot(struct rwlock *rw) {
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        if (!rw->readers[i]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int readers_held(struct rwlock *rw) {
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        if (rw->readers[i]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Record a contended rwlock in a holder's list, if it is not already there */
+static void held_rwlocks_insert(task_t *task, struct rwlock *rw) {
+    struct rwlock **list = task->mutex_data.held_rwlocks;
+    int free = -1;
+
+    for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
+        if (list[i] == rw) {
+            return;
+        }
+
+        if (list[i] == NULL && free < 0) {
+            free = i;
+        }
+    }
+
+    if (free < 0) {
+        panic_print("Too many rwlocks already held in list (0x%x).", list);
+    }
+
+    list[free] = rw;
+}
+
+/* Forget a released rwlock, and drop anything inherited through it */
+static void held_rwlocks_remove(task_t *task, struct rwlock *rw) {
+    struct rwlock **list = task->mutex_data.held_rwlocks;
+
+    for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
+        if (list[i] == rw) {
+            list[i] = NULL;
+            priority_inherit(task);
+            return;
+        }
+    }
+}
+
+/*
+ * Update the inheritance of every holder, after the waiters change
+ *
+ * While tasks wait, each reader slot is marked, so readers release through
+ * the kernel, and every holder inherits from the waiters.
+ */
+static void inherit_holders(struct rwlock *rw) {
+    int contended = rw->state & RWLOCK_CONTENDED;
+
+    for (int i = 0; i < RWLOCK_READERS_MAX; i++) {
+        task_t *reader = slot_task(rw->readers[i]);
+
+        if (!reader) {
+            continue;
+        }
+
+        if (contended) {
+            rw->readers[i] |= RWLOCK_READER_KERNEL;
+            held_rwlocks_insert(reader, rw);
+        }
+
+        priority_inherit(reader);
+    }
+
+    if (rw->writer) {
+        if (contended) {
+            held_rwlocks_insert(rw->writer, rw);
+        }
+
+        priority_inherit(rw->writer);
+    }
+}
+
+/* Keep RWLOCK_CONTENDED set exactly while tasks are waiting */
+static void update_contended(struct rwlock *rw) {
+    if (list_empty(&rw->read_waiters) && list_empty(&rw->write_waiters)) {
+        rw->state &= ~RWLOCK_CONTENDED;
+    }
+    else {
+        rw->state |= RWLOCK_CONTENDED;
+    }
+}
+
+/* Switch to woken, if it should preempt the current task */
+static void preempt(task_t *woken) {
+    if (woken && task_compare(woken, curr_task) > 0) {
+        task_switch(NULL);
+    }
+}
+
+/*
+ * Block curr_task on waiters until it is handed the lock
+ *
+ * As task_wait(), but the holders inherit from curr_task before the
+ * scheduler picks the next task.
+ */
+static void wait_for_lock(struct rwlock *rw, struct list *waiters) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+    struct list *element;
+
+    list_for_each(element, waiters) {
+        task_t *waiter = list_entry(element, task_t, wait_data.wait_list);
+
+        if (task_compare(curr_task, waiter) > 0) {
+            break;
+        }
+    }
+
+    list_insert_before(&wait->wait_list, element);
+    wait->status = -1;
+
+    update_contended(rw);
+    inherit_holders(rw);
+
+    task_block(curr_task, TIMEOUT_FOREVER);
+    task_switch(NULL);
+}
+
+/* Hand the lock to the first waiting writer.  Returns the writer. */
+static task_t *wake_writer(struct rwlock *rw) {
+    task_t *waiter = list_entry(rw->write_waiters.next, task_t,
+                                wait_data.wait_list);
+
+    task_wait_wake(waiter);
+
+    rw->state |= RWLOCK_WRITER;
+    rw->writer = waiter;
+
+    return waiter;
+}
+
+/*
+ * Hand the lock to waiting readers, while reader slots are free.  Returns
+ * the highest priority reader woken.
+ */
+static task_t *wake_readers(struct rwlock *rw) {
+    task_t *woken = NULL;
+    int i = 0;
+
+    while (!list_empty(&rw->read_waiters)) {
+        task_t *waiter = list_entry(rw->read_waiters.next, task_t,
+                                    wait_data.wait_list);
+
+        while (i < RWLOCK_READERS_MAX && rw->readers[i]) {
+            i++;
+        }
+
+        if (i == RWLOCK_READERS_MAX) {
+            break;
+        }
+
+        /* Removes waiter from the list */
+        task_wait_wake(waiter);
+        rw->readers[i] = (uint32_t) waiter;
+
+        if (task_compare(waiter, woken) > 0) {
+            woken = waiter;
+        }
+    }
+
+    return woken;
+}
+
+/*
+ * Hand the lock on once it is free, writers first
+ *
+ * Returns the highest priority task woken, if any.
+ */
+static task_t *hand_off(struct rwlock *rw) {
+    task_t *woken = NULL;
+
+    if (!list_empty(&rw->write_waiters)) {
+        if (!(rw->state & RWLOCK_WRITER) && !readers_held(rw)) {
+            woken = wake_writer(rw);
+        }
+    }
+    else if (!(rw->state & RWLOCK_WRITER)) {
+        woken = wake_readers(rw);
+    }
+
+    update_contended(rw);
+    inherit_holders(rw);
+
+    return woken;
+}
+
+static void svc_read_acquire(struct rwlock *rw) {
+    int slot = find_slot(rw, curr_task);
+
+    /* Marked by the kernel after we claimed it, so we hold the lock */
+    if (slot >= 0 && (rw->readers[slot] & RWLOCK_READER_KERNEL)) {
+        return;
+    }
+
+    /* Not held by a writer, and no writers waiting */
+    if (!(rw->state & RWLOCK_WRITER) && list_empty(&rw->write_waiters)) {
+        if (slot < 0) {
+            slot = free_slot(rw);
+        }
+
+        if (slot >= 0) {
+            rw->readers[slot] = (uint32_t) curr_task;
+
+            /* Readers are waiting for a slot, so we must release to them */
+            if (rw->state & RWLOCK_CONTENDED) {
+                inherit_holders(rw);
+            }
+
+            return;
+        }
+    }
+
+    if (rw->writer == curr_task) {
+        panic_print("Task (0x%x) attempted to read rwlock 0x%x it is "
+                    "writing", curr_task, rw);
+    }
+
+    /*
+     * Give back a slot claimed after a writer took or waited for the lock.
+     * A waiting writer may have been waiting on the slot alone.  We block
+     * next, so there is no need to preempt for it.
+     */
+    if (slot >= 0) {
+        rw->readers[slot] = 0;
+        hand_off(rw);
+    }
+
+    /* Woken holding the lock, by the release that frees it for us */
+    wait_for_lock(rw, &rw->read_waiters);
+}
+
+static void svc_read_release(struct rwlock *rw) {
+    int slot = find_slot(rw, curr_task);
+
+    if (slot < 0) {
+        panic_print("Task (0x%x) released rwlock 0x%x it is not reading",
+                    curr_task, rw);
+    }
+
+    rw->readers[slot] = 0;
+    held_rwlocks_remove(curr_task, rw);
+
+    preempt(hand_off(rw));
+}
+
+static void svc_write_acquire(struct rwlock *rw) {
+    if (rw->writer == curr_task) {
+        panic_print("Task (0x%x) attempted to double acquire rwlock 0x%x",
+                    curr_task, rw);
+    }
+
+    if (find_slot(rw, curr_task) >= 0) {
+        panic_print("Task (0x%x) attempted to write rwlock 0x%x it is "
+                    "reading", curr_task, rw);
+    }
+
+    if (!(rw->state & RWLOCK_WRITER) && !readers_held(rw)
+            && list_empty(&rw->write_waiters)) {
+        rw->state |= RWLOCK_WRITER;
+        rw->writer = curr_task;
+        return;
+    }
+
+    /* Woken holding the lock, by the last holder to release */
+    wait_for_lock(rw, &rw->write_waiters);
+}
+
+static void svc_write_release(struct rwlock *rw) {
+    if (rw->writer != curr_task) {
+        panic_print("Task (0x%x) released rwlock 0x%x it is not writing",
+                    curr_task, rw);
+    }
+
+    rw->state &= ~RWLOCK_WRITER;
+    rw->writer = NULL;
+    held_rwlocks_remove(curr_task, rw);
+
+    preempt(hand_off(rw));
+}
+
+void read_acquire(struct rwlock *rw) {
+    PANIC_ON(!arch_svc_legal());
+
+    if (!task_switching) {
+        svc_read_acquire(rw);
+        return;
+    }
+
+    /*
+     * Fast path, while no writer holds or waits for the lock.  The slot is
+     * claimed before checking, so a writer arriving in between sees us,
+     * and counts us as a reader.
+     */
+    if (claim_slot(rw)) {
+        smp_mb();
+
+        if (!(*state_word(rw) & (RWLOCK_WRITER | RWLOCK_CONTENDED))) {
+            return;
+        }
+    }
+
+    SVC_ARG(SVC_RWLOCK_READ_ACQUIRE, rw);
+}
+
+void read_release(struct rwlock *rw) {
+    if (!task_switching) {
+        svc_read_release(rw);
+        return;
+    }
+
+    /* Fast path, unless the kernel marked our slot while tasks waited */
+    if (clear_slot(rw)) {
+        return;
+    }
+
+    SVC_ARG(SVC_RWLOCK_READ_RELEASE, rw);
+}
+
+void write_acquire(struct rwlock *rw) {
+    PANIC_ON(!arch_svc_legal());
+
+    if (!task_switching) {
+        svc_write_acquire(rw);
+        return;
+    }
+
+    SVC_ARG(SVC_RWLOCK_WRITE_ACQUIRE, rw);
+}
+
+void write_release(struct rwlock *rw) {
+    if (!task_switching) {
+        svc_write_release(rw);
+        return;
+    }
+
+    SVC_ARG(SVC_RWLOCK_WRITE_RELEASE, rw);
+}
+
+uint8_t rwlock_inherited_priority(task_t *task, uint8_t priority) {
+    for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
+        struct rwlock *rw = task->mutex_data.held_rwlocks[i];
+        task_t *waiter;
+
+        if (!rw) {
+            continue;
+        }
+
+        list_for_each_entry(waiter, &rw->read_waiters, wait_data.wait_list) {
+            if (task_priority(waiter) > priority) {
+                priority = task_priority(waiter);
+            }
+        }
+
+        list_for_each_entry(waiter, &rw->write_waiters, wait_data.wait_list) {
+            if (task_priority(waiter) > priority) {
+                priority = task_priority(waiter);
+            }
+        }
+    }
+
+    return priority;
+}
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+/* Fold the deadlines of the tasks on waiters into deadline */
+static int waiters_deadline(struct list *waiters, int found,
+                            uint32_t *deadline) {
+    task_t *waiter;
+
+    list_for_each_entry(waiter, waiters, wait_data.wait_list) {
+        uint32_t waiter_deadline;
+
+        if (!task_deadline(waiter, &waiter_deadline)) {
+            continue;
+        }
+
+        if (!found || (int32_t) (waiter_deadline - *deadline) < 0) {
+            *deadline = waiter_deadline;
+            found = 1;
+        }
+    }
+
+    return found;
+}
+
+int rwlock_inherited_deadline(task_t *task, int found, uint32_t *deadline) {
+    for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
+        struct rwlock *rw = task->mutex_data.held_rwlocks[i];
+
+        if (!rw) {
+            continue;
+        }
+
+        found = waiters_deadline(&rw->read_waiters, found, deadline);
+        found = waiters_deadline(&rw->write_waiters, found, deadline);
+    }
+
+    return found;
+}
+#endif
+
+int rwlock_service_call(uint32_t svc_number, ...) {
+    int ret = 0;
+    va_list ap;
+    va_start(ap, svc_number);
+
+    switch (svc_number) {
+        case SVC_RWLOCK_READ_ACQUIRE: {
+            struct rwlock *rw = va_arg(ap, struct rwlock *);
+            svc_read_acquire(rw);
+            break;
+        }
+        case SVC_RWLOCK_READ_RELEASE: {
+            struct rwlock *rw = va_arg(ap, struct rwlock *);
+            svc_read_release(rw);
+            break;
+        }
+        case SVC_RWLOCK_WRITE_ACQUIRE: {
+            struct rwlock *rw = va_arg(ap, struct rwlock *);
+            svc_write_acquire(rw);
+            break;
+        }
+        case SVC_RWLOCK_WRITE_RELEASE: {
+            struct rwlock *rw = va_arg(ap, struct rwlock *);
+            svc_write_release(rw);
+            break;
+        }
+        default:
+            panic_print("Unknown SVC: %d", svc_number);
+            break;
+    }
+
+    va_end(ap);
+
+    return ret;
+}
@@ -40,9 +40,11 @@ void kernel_task(void) {
         /* Free abandoned mutexes */
         for (int i = 0; i < HELD_MUTEXES_MAX; i++) {
             struct task_mutex_data *mut_data = &get_task_t(task)->mutex_data;
+            struct mutex *mutex = mut_data->held_mutexes[i];
 
-            if (mut_data->held_mutexes[i]) {
-                release(mut_data->held_mutexes[i]);
+            /* Skip a stale entry for a mutex released on the fast path */
+            if (mutex && mutex_owner(mutex) == get_task_t(task)) {
+                release(mutex);
             }
         }
 
@@ -53,6 +55,10 @@ void kernel_task(void) {
 void sleep_task(void) {
     /* Run when there is nothing else to run */
     while (1) {
+#ifdef CONFIG_TICKLESS_IDLE
+        tickless_idle();
+#else
         arch_wait_for_interrupt();
+#endif
     }
 }
@@ -40,6 +40,31 @@ int task_compare(task_t *task1, task_t *task2) {
     struct task_ctrl *t1 = get_task_ctrl(task1);
     struct task_ctrl *t2 = get_task_ctrl(task2);
 
+#ifdef CONFIG_SCHED_POLICY_EDF
+    /*
+     * Periodic tasks, and those inheriting a deadline, are ordered by
+     * deadline, ahead of all others
+     */
+    if (deadline_scheduled(t1) && deadline_scheduled(t2)) {
+        int32_t diff = effective_deadline(t2) - effective_deadline(t1);
+
+        if (diff > 0) {
+            return 1;
+        }
+        else if (diff < 0) {
+            return -1;
+        }
+
+        return 0;
+    }
+    else if (deadline_scheduled(t1)) {
+        return 1;
+    }
+    else if (deadline_scheduled(t2)) {
+        return -1;
+    }
+#endif
+
     if (t1->priority > t2->priority) {
         return 1;
     }
@@ -50,16 +75,110 @@ int task_compare(task_t *task1, task_t *task2) {
     return 0;
 }
 
+uint8_t task_priority(task_t *task) {
+    return get_task_ctrl(task)->priority;
+}
+
+uint8_t task_base_priority(task_t *task) {
+    return get_task_ctrl(task)->base_priority;
+}
+
+void task_set_priority(task_t *task, uint8_t priority) {
+    task_ctrl *t = get_task_ctrl(task);
+
+    if (t->priority == priority) {
+        return;
+    }
+
+    /* Move to the ready list for the new priority */
+    if (task_runnable(task)) {
+        ready_queue_remove(t);
+        t->priority = priority;
+        ready_queue_reinsert(t);
+    }
+    else {
+        t->priority = priority;
+    }
+}
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+int task_deadline(task_t *task, uint32_t *deadline) {
+    task_ctrl *t = get_task_ctrl(task);
+
+    if (!deadline_scheduled(t)) {
+        return 0;
+    }
+
+    *deadline = effective_deadline(t);
+
+    return 1;
+}
+
+int task_inherit_deadline(task_t *task, int inherit, uint32_t deadline) {
+    task_ctrl *t = get_task_ctrl(task);
+    int runnable;
+
+    if (!inherit && !t->inheriting) {
+        return 0;
+    }
+
+    if (inherit && t->inheriting && t->inherit_deadline == deadline) {
+        return 0;
+    }
+
+    /* Move to its new place in the ready queue */
+    runnable = task_runnable(task);
+    if (runnable) {
+        ready_queue_remove(t);
+    }
+
+    t->inheriting = inherit;
+    t->inherit_deadline = deadline;
+
+    if (runnable) {
+        ready_queue_reinsert(t);
+    }
+
+    return 1;
+}
+
+void task_set_immediate_deadline(task_t *task) {
+    task_ctrl *t = get_task_ctrl(task);
+    int runnable;
+
+    if (t->period || t->immediate) {
+        return;
+    }
+
+    /* Move from the priority lists to the deadline list */
+    runnable = task_runnable(task);
+    if (runnable) {
+        ready_queue_remove(t);
+    }
+
+    t->immediate = 1;
+    t->deadline = system_ticks;
+
+    if (runnable) {
+        ready_queue_reinsert(t);
+    }
+}
+#endif
+
 uint8_t task_runnable(task_t *task) {
-    task_ctrl *match = get_task_ctrl(task);
-    task_ctrl *node;
+    task_ctrl *t = get_task_ctrl(task);
 
-    list_for_each_entry(node, &runnable_task_list, runnable_task_list) {
-        if (node == match) {
-            return 1;
-        }
+    /* Tasks are only linked into a list while in the ready queue */
+    return !list_empty(&t->runnable_task_list);
+}
+
+int task_sleep(uint32_t usecs) {
+    if (!task_switching || !arch_svc_legal()) {
+        return -1;
     }
 
+    SVC_ARG(SVC_SLEEP, usecs);
+
     return 0;
 }
 
@@ -30,6 +30,11 @@
 #include "sched_internals.h"
 
 void free_task(task_ctrl *task) {
+    /* Static tasks were never allocated */
+    if (task->static_alloc) {
+        return;
+    }
+
     free(task->stack_limit);
     kfree(task);
 }
@@ -56,21 +61,32 @@ void sched_svc_end_task(void) {
                     task, task->fptr, task->stack_top, task->stack_limit);
     }
 
-    list_remove(&task->runnable_task_list);
+    ready_queue_remove(task);
 
     /* Periodic (but only if aborted) */
     if (task->period && task->abort) {
-        list_remove(&task->periodic_task_list);
+        periodic_queue_remove(task);
     }
 
     /* Periodic (but only if not aborted) */
     if (!task->abort && task->period) {
+        uint32_t response;
+
         task->running = 0;
 
+        /* Job complete, measure its response time */
+        task->completion_time = system_ticks;
+        response = task->completion_time - task->release_time;
+        if (response > task->max_response) {
+            task->max_response = response;
+        }
+
         /* Reset stack */
         task->stack_top = task->stack_base;
     }
     else {
+        list_remove(&task->all_task_list);
+
         /* Add to queue for freeing */
         list_add(&task->free_task_list, &free_task_list);
 
@@ -52,4 +52,5 @@ static void task_io_setup(task_t *task) {
 void generic_task_setup(task_t *task) {
     task_io_setup(task);
     task_mutex_setup(task);
+    list_init(&task->wait_data.wait_list);
 }
@@ -23,89 +23,322 @@
 #ifndef KERNEL_SCHED_SCHED_INTERNALS_H_INCLUDED
 #define KERNEL_SCHED_SCHED_INTERNALS_H_INCLUDED
 
+#include <math.h>
 #include <stdint.h>
+#include <time.h>
 #include <list.h>
+#include <kernel/tasklet.h>
 
 #define STKSIZE     CONFIG_TASK_STACK_SIZE      /* This is in words */
 
-struct list runnable_task_list;
-struct list periodic_task_list;
-struct list free_task_list;
+/* Unused stack words hold this pattern, for finding the high-water mark */
+#define STACK_PAINT 0xa5a5a5a5
 
-void svc_register_task(task_ctrl *task, int periodic) __attribute__((section(".kernel")));
+#define SCHED_PRIORITIES    CONFIG_SCHED_PRIORITIES
+#define READY_BITMAP_WORDS  ((SCHED_PRIORITIES + 31) / 32)
 
 /*
- * Switch to task
+ * Ready queue
  *
- * NULL task is equivalent to yield, allowing the scheduler to select a task.
+ * One FIFO list of runnable tasks per priority, plus a two-level bitmap of
+ * the priorities which have runnable tasks.  The highest runnable priority
+ * is found with two CLZ operations, so selecting, inserting, and removing
+ * tasks are all constant time, regardless of the number of tasks.
  *
- * Returns an error if task does not exist or is not runnable.
+ * A priority list is only valid while its bit is set in the bitmap, which
+ * allows the queue to be used from .bss without initialization.
  *
- * @param task  Task to switch to, NULL to yield
- * Return 0 on success, negative on error
+ * With CONFIG_SCHED_POLICY_EDF, runnable periodic tasks, and tasks
+ * inheriting their deadlines, are instead kept in a separate list sorted by
+ * deadline, which always runs ahead of the priority lists.
  */
-int svc_task_switch(task_ctrl *task) __attribute__((section(".kernel")));
+struct ready_queue {
+    /* Bit n set if bitmap[n] is non-zero */
+    uint32_t    group;
+    /* Bit m of bitmap[n] set if priority 32*n + m has runnable tasks */
+    uint32_t    bitmap[READY_BITMAP_WORDS];
+    struct list tasks[SCHED_PRIORITIES];
+};
 
-void end_task(void) __attribute__((section(".kernel"),naked));
-void sched_svc_end_task(void) __attribute__((section(".kernel")));
-void free_task(task_ctrl *task) __attribute__((section(".kernel")));
-
-uint8_t task_exists(task_t *task) __attribute__((section(".kernel")));
-
-void kernel_task(void) __attribute__((section(".kernel")));
-void sleep_task(void) __attribute__((section(".kernel")));
+extern struct ready_queue ready_queue;
 
-/* Place task in task list based on priority
- * Struct member and global task list have same name */
-#define DECLARE_INSERT_TASK_FUNC(task_list_name)                                    \
-    void _insert_task_##task_list_name(struct task_ctrl *new_task);                 \
+/*
+ * Delta queues
+ *
+ * Items, usually tasks, are kept sorted by expiration.  Each item's delta
+ * member holds the number of ticks between its expiration and the
+ * expiration of the item before it, so a system tick only needs to update
+ * the head of the queue, and only touches items that actually expire.
+ *
+ * DEFINE_DELTA_QUEUE(name, type, ...) defines the following functions:
+ *
+ * void name_insert(type *item, uint32_t delay)
+ *      Add item to queue, to expire in delay ticks.  delay must be > 0.
+ * void name_remove(type *item)
+ *      Remove item from queue.  No-op if item is not queued.
+ * uint32_t name_next(void)
+ *      Ticks until next expiration, UINT32_MAX if queue is empty.
+ * void name_advance(uint32_t ticks)
+ *      Advance queue by ticks, which must not exceed name_next().
+ * type *name_pop_expired(void)
+ *      Remove and return the next expired item, NULL if none have expired.
+ *
+ * The global list head and type's list member share a name.
+ */
+#define DECLARE_DELTA_QUEUE(name, type)                                             \
+    void name##_insert(type *item, uint32_t delay);                                 \
+    void name##_remove(type *item);                                                 \
+    uint32_t name##_next(void);                                                     \
+    void name##_advance(uint32_t ticks);                                            \
+    type *name##_pop_expired(void);
 
-#define DEFINE_INSERT_TASK_FUNC(task_list_name)                                     \
-    void _insert_task_##task_list_name(struct task_ctrl *new_task) {                \
-        /* First task in list */                                                    \
-        struct task_ctrl *task = list_entry(task_list_name.next,                    \
-                struct task_ctrl, task_list_name);                                  \
+#define DEFINE_DELTA_QUEUE(name, type, list_name, delta)                            \
+    void name##_insert(type *item, uint32_t delay) {                                \
+        struct list *element;                                                       \
+                                                                                    \
+        /* Find first item expiring strictly after this one */                      \
+        list_for_each(element, &list_name) {                                        \
+            type *next = list_entry(element, type, list_name);                      \
+                                                                                    \
+            if (delay < next->delta) {                                              \
+                next->delta -= delay;                                               \
+                break;                                                              \
+            }                                                                       \
+                                                                                    \
+            delay -= next->delta;                                                   \
+        }                                                                           \
+                                                                                    \
+        item->delta = delay;                                                        \
+                                                                                    \
+        /* If no later item was found, element is the list head, add to end */      \
+        list_insert_before(&item->list_name, element);                              \
+    }                                                                               \
                                                                                     \
-        /* New task is the highest priority, add to front */                        \
-        if (list_empty(&task_list_name) || (new_task->priority > task->priority)) { \
-            list_add_head(&new_task->task_list_name, &task_list_name);              \
+    void name##_remove(type *item) {                                                \
+        struct list *element = item->list_name.next;                                \
+                                                                                    \
+        if (list_empty(&item->list_name)) {                                         \
             return;                                                                 \
         }                                                                           \
                                                                                     \
-        /* Last task in list */                                                     \
-        task = list_entry(list_tail(&task_list_name), struct task_ctrl,             \
-                task_list_name);                                                    \
+        /* The next item inherits the remaining delay */                            \
+        if (element != &list_name) {                                                \
+            type *next = list_entry(element, type, list_name);                      \
+            next->delta += item->delta;                                             \
+        }                                                                           \
+                                                                                    \
+        list_remove(&item->list_name);                                              \
+        list_init(&item->list_name);                                                \
+    }                                                                               \
+                                                                                    \
+    uint32_t name##_next(void) {                                                    \
+        if (list_empty(&list_name)) {                                               \
+            return UINT32_MAX;                                                      \
+        }                                                                           \
+                                                                                    \
+        return list_entry(list_name.next, type, list_name)->delta;                  \
+    }                                                                               \
                                                                                     \
-        /* New task is the lowest priority, add to end */                           \
-        if (new_task->priority <= task->priority) {                                 \
-            list_add_tail(&new_task->task_list_name, &task_list_name);              \
+    void name##_advance(uint32_t ticks) {                                           \
+        if (list_empty(&list_name)) {                                               \
             return;                                                                 \
         }                                                                           \
                                                                                     \
-        /* New task is in the middle, add after last equal priority task */         \
-        struct list *element;                                                       \
-        struct list *insert_point = NULL;                                           \
+        list_entry(list_name.next, type, list_name)->delta -= ticks;                \
+    }                                                                               \
                                                                                     \
-        list_for_each(element, &task_list_name) {                                   \
-            struct task_ctrl *task = list_entry(element, struct task_ctrl,          \
-                    task_list_name);                                                \
+    type *name##_pop_expired(void) {                                                \
+        type *item;                                                                 \
                                                                                     \
-            if (new_task->priority > task->priority) {                              \
-                insert_point = element;                                             \
-            }                                                                       \
+        if (list_empty(&list_name)) {                                               \
+            return NULL;                                                            \
         }                                                                           \
                                                                                     \
-        if (!insert_point) {                                                        \
-            panic_print("Unable to place priority %d task in %s",                   \
-                    new_task->priority, #task_list_name);                           \
+        item = list_entry(list_name.next, type, list_name);                         \
+        if (item->delta) {                                                          \
+            return NULL;                                                            \
         }                                                                           \
                                                                                     \
-        list_insert_before(&new_task->task_list_name, insert_point);                \
+        list_remove(&item->list_name);                                              \
+        list_init(&item->list_name);                                                \
+                                                                                    \
+        return item;                                                                \
+    }
+
+/* Periodic tasks, sorted by next release */
+extern struct list periodic_task_list;
+DECLARE_DELTA_QUEUE(periodic_queue, task_ctrl);
+
+/* Blocked tasks with a timeout, sorted by timeout */
+extern struct list sleep_task_list;
+DECLARE_DELTA_QUEUE(sleep_queue, task_ctrl);
+
+#ifdef CONFIG_TASKLETS
+/* Started tasklets, sorted by next release */
+extern struct list tasklet_queue;
+DECLARE_DELTA_QUEUE(tasklet_queue, struct tasklet);
+
+/* Release tasklets whose delay has expired */
+void tasklet_tick(void) __attribute__((section(".kernel")));
+#else
+static inline uint32_t tasklet_queue_next(void) {
+    return UINT32_MAX;
+}
+
+static inline void tasklet_queue_advance(uint32_t ticks) {}
+static inline void tasklet_tick(void) {}
+#endif
+
+struct list free_task_list;
+
+/* All registered tasks, for statistics */
+extern struct list all_task_list;
+
+void svc_register_task(task_ctrl *task, int periodic) __attribute__((section(".kernel")));
+
+/*
+ * Switch to task
+ *
+ * NULL task is equivalent to yield, allowing the scheduler to select a task.
+ *
+ * Returns an error if task does not exist or is not runnable.
+ *
+ * @param task  Task to switch to, NULL to yield
+ * Return 0 on success, negative on error
+ */
+int svc_task_switch(task_ctrl *task) __attribute__((section(".kernel")));
+
+void end_task(void) __attribute__((section(".kernel"),naked));
+void sched_svc_end_task(void) __attribute__((section(".kernel")));
+void free_task(task_ctrl *task) __attribute__((section(".kernel")));
+
+uint8_t task_exists(task_t *task) __attribute__((section(".kernel")));
+
+/*
+ * Ticks between releases of a periodic task
+ *
+ * A task counts down a full period of ticks, and is released on the
+ * following tick.
+ */
+static __always_inline uint32_t periodic_release_ticks(task_ctrl *task) {
+    return task->period + 1;
+}
+
+/* Convert microseconds to system ticks, rounding up */
+static __always_inline uint32_t us_to_ticks(uint32_t us) {
+    /* Tick period in us / tick */
+    uint32_t tick_period_us = 1000*1000 / CONFIG_SYSTICK_FREQ;
+
+    return DIV_ROUND_UP(us, tick_period_us);
+}
+
+/* Wake tasks whose timeout has expired */
+void sleep_queue_tick(void) __attribute__((section(".kernel")));
+
+/*
+ * Put current task to sleep for usecs microseconds
+ *
+ * Blocks the task, and switches away from it.
+ */
+void svc_sleep(uint32_t usecs) __attribute__((section(".kernel")));
+
+/*
+ * Account for a task switch
+ *
+ * Charges the time since the last switch to prev, and counts the switch to
+ * next, along with its latency since becoming ready.
+ */
+void sched_account_switch(task_ctrl *prev, task_ctrl *next) __attribute__((section(".kernel")));
+
+/* Fill stats for up to max tasks.  Returns number of tasks filled. */
+int svc_task_stats(struct task_stats *stats, int max) __attribute__((section(".kernel")));
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+/* Returns non-zero if deadline a is before deadline b, across wraparound */
+static __always_inline int deadline_before(uint32_t a, uint32_t b) {
+    return (int32_t) (a - b) < 0;
+}
+
+/*
+ * Returns non-zero if task is scheduled by deadline
+ *
+ * Periodic tasks are, as are tasks with an immediate deadline, and tasks
+ * inheriting a deadline from a periodic task blocked on them.
+ */
+static __always_inline int deadline_scheduled(task_ctrl *task) {
+    return task->period || task->immediate || task->inheriting;
+}
+
+/* Deadline task is scheduled by, the earlier of its own and any inherited */
+static __always_inline uint32_t effective_deadline(task_ctrl *task) {
+    if (!task->period && !task->immediate) {
+        return task->inherit_deadline;
+    }
+
+    if (task->inheriting
+            && deadline_before(task->inherit_deadline, task->deadline)) {
+        return task->inherit_deadline;
     }
 
-#define insert_task(task_list_name, new_task)   _insert_task_##task_list_name(new_task)
+    return task->deadline;
+}
+#endif
 
-DECLARE_INSERT_TASK_FUNC(runnable_task_list);
-DECLARE_INSERT_TASK_FUNC(periodic_task_list);
+/*
+ * Add task to the tail of its priority in the ready queue
+ *
+ * For tasks becoming runnable.  Starts measuring the task's latency until
+ * it runs.
+ */
+void ready_queue_insert(task_ctrl *task) __attribute__((section(".kernel")));
+
+/*
+ * Add task back to the ready queue
+ *
+ * For moving a task, already runnable or running, after ready_queue_remove()
+ * and a change of priority or deadline.  Its latency is still measured from
+ * when it became runnable.
+ */
+void ready_queue_reinsert(task_ctrl *task) __attribute__((section(".kernel")));
+
+/* Remove task from the ready queue */
+void ready_queue_remove(task_ctrl *task) __attribute__((section(".kernel")));
+
+/*
+ * Select next task to run
+ *
+ * Returns the task at the head of the highest runnable priority, after
+ * moving it to the tail of that priority, for round-robin scheduling of
+ * equal priority tasks.  With CONFIG_SCHED_POLICY_EDF, the runnable periodic
+ * task with the earliest deadline is returned first.  Returns NULL if no
+ * tasks are runnable.
+ */
+task_ctrl *ready_queue_next(void) __attribute__((section(".kernel")));
+
+/* Returns non-zero if task is the only task in the ready queue */
+int ready_queue_only(task_ctrl *task) __attribute__((section(".kernel")));
+
+/*
+ * Release the next job of a periodic task
+ *
+ * The job's deadline is the task's following release.
+ */
+static __always_inline void periodic_task_release(task_ctrl *task) {
+    task->release_time = system_ticks;
+    task->deadline = system_ticks + periodic_release_ticks(task);
+    ready_queue_insert(task);
+}
+
+/*
+ * Idle until the next system event, with system ticks suppressed
+ *
+ * Called by the idle task.  If the idle task is the only runnable task,
+ * system ticks are suppressed until the next periodic release or timeout,
+ * and the skipped ticks are accounted for on wakeup.
+ */
+void tickless_idle(void) __attribute__((section(".kernel")));
+
+void kernel_task(void) __attribute__((section(".kernel")));
+void sleep_task(void) __attribute__((section(".kernel")));
 
 #endif
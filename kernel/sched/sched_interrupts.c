@@ -22,6 +22,7 @@
 
 #include <stdarg.h>
 #include <stdint.h>
+#include <compiler.h>
 #include <time.h>
 #include <kernel/fault.h>
 #include <kernel/sched.h>
@@ -29,11 +30,14 @@
 #include "sched_internals.h"
 
 void sched_system_tick(void) {
-    system_ticks++;
+    clock_advance(1);
 
     /* Update periodic tasks */
     rtos_tick();
 
+    /* Wake tasks whose timeouts have expired */
+    sleep_queue_tick();
+
     /* Run the scheduler */
     task_switch(NULL);
 }
@@ -61,6 +65,17 @@ int sched_service_call(uint32_t svc_number, ...) {
             ret = svc_task_switch(task);
             break;
         }
+        case SVC_SLEEP: {
+            uint32_t usecs = va_arg(ap, uint32_t);
+            svc_sleep(usecs);
+            break;
+        }
+        case SVC_TASK_STATS: {
+            struct task_stats *stats = va_arg(ap, struct task_stats *);
+            int max = va_arg(ap, int);
+            ret = svc_task_stats(stats, max);
+            break;
+        }
         default:
             panic_print("Unknown SVC: %d", svc_number);
             break;
@@ -70,3 +85,8 @@ int sched_service_call(uint32_t svc_number, ...) {
 
     return ret;
 }
+
+/* By default, time only advances by whole system ticks */
+uint32_t __weak arch_sched_tick_elapsed_ns(void) {
+    return 0;
+}
@@ -26,55 +26,81 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <linker_array.h>
 #include <list.h>
 #include <mm/mm.h>
 #include <kernel/fault.h>
 
 #include <kernel/sched.h>
 #include <kernel/sched_internals.h>
+#include <kernel/static_task.h>
 #include "sched_internals.h"
 
-struct list runnable_task_list = INIT_LIST(runnable_task_list);
-struct list periodic_task_list = INIT_LIST(periodic_task_list);
-
-DEFINE_INSERT_TASK_FUNC(runnable_task_list);
-DEFINE_INSERT_TASK_FUNC(periodic_task_list);
-
 volatile uint32_t total_tasks = 0;
 
-static task_ctrl *create_task(void (*fptr)(void), uint8_t priority,
-                              uint32_t period) {
-    task_ctrl *task;
-    uint32_t *memory;
+/* Set up a task on the given stack, without allocating anything */
+static void init_task(task_ctrl *task, uint32_t *stack, uint32_t stack_words,
+                      void (*fptr)(void), uint8_t priority, uint32_t period) {
     static uint32_t pid_source = 1;
-    task = (task_ctrl *) kmalloc(sizeof(task_ctrl));
-    if (task == NULL) {
-        return NULL;
-    }
 
-    memory = (uint32_t *) malloc(STKSIZE*4);
-    if (memory == NULL) {
-        kfree(task);
-        return NULL;
-    }
+    /* Painted, so the high-water mark can be found later */
+    memset32(stack, STACK_PAINT, stack_words * sizeof(uint32_t));
 
-    task->stack_limit       = memory;
-    task->stack_base        = memory + STKSIZE;
-    task->stack_top         = memory + STKSIZE;
+    task->stack_limit       = stack;
+    task->stack_base        = stack + stack_words;
+    task->stack_top         = stack + stack_words;
     task->fptr              = fptr;
     task->priority          = priority;
+    task->base_priority     = priority;
     task->running           = 0;
     task->abort             = 0;
+    task->blocked           = 0;
+    task->timed_out         = 0;
+    task->static_alloc      = 0;
 
     task->period            = period;
-    task->ticks_until_wake  = period;
+    task->ticks_until_wake  = 0;
+    task->deadline          = 0;
+    task->inherit_deadline  = 0;
+    task->inheriting        = 0;
+    task->immediate         = 0;
+    task->sleep_ticks       = 0;
     task->pid               = pid_source++;
-
+    task->runtime           = 0;
+    task->ready_timestamp   = 0;
+    task->max_latency       = 0;
+    task->switches          = 0;
+    task->release_time      = 0;
+    task->completion_time   = 0;
+    task->max_response      = 0;
+    task->overruns          = 0;
+
+    list_init(&task->all_task_list);
     list_init(&task->runnable_task_list);
     list_init(&task->periodic_task_list);
+    list_init(&task->sleep_task_list);
     list_init(&task->free_task_list);
 
     generic_task_setup(get_task_t(task));
+}
+
+static task_ctrl *create_task(void (*fptr)(void), uint8_t priority,
+                              uint32_t period, uint32_t stack_words) {
+    task_ctrl *task;
+    uint32_t *memory;
+
+    task = (task_ctrl *) kmalloc(sizeof(task_ctrl));
+    if (task == NULL) {
+        return NULL;
+    }
+
+    memory = (uint32_t *) malloc(stack_words*4);
+    if (memory == NULL) {
+        kfree(task);
+        return NULL;
+    }
+
+    init_task(task, memory, stack_words, fptr, priority, period);
 
     return task;
 }
@@ -92,20 +118,31 @@ static int register_task(task_ctrl *task, int periodic) {
     return 0;
 }
 
+static void check_priority(uint8_t priority) {
+    if (priority >= SCHED_PRIORITIES) {
+        panic_print("Task priority %d exceeds maximum priority %d",
+                    priority, SCHED_PRIORITIES - 1);
+    }
+}
+
 task_t *new_task(void (*fptr)(void), uint8_t priority, uint32_t period_us) {
-    uint32_t tick_period_us, period_ticks;
+    return new_task_ex(fptr, priority, period_us, STKSIZE);
+}
+
+task_t *new_task_ex(void (*fptr)(void), uint8_t priority, uint32_t period_us,
+                    uint32_t stack_words) {
+    uint32_t period_ticks;
     task_ctrl *task;
 
-    /* Tick period in us / tick */
-    tick_period_us = 1000*1000 / CONFIG_SYSTICK_FREQ;
+    check_priority(priority);
 
     /*
      * Round ticks up, ensuring that short period tasks are not
      * treated as non-periodic, if even one tick is too long.
      */
-    period_ticks = DIV_ROUND_UP(period_us, tick_period_us);
+    period_ticks = us_to_ticks(period_us);
 
-    task = create_task(fptr, priority, period_ticks);
+    task = create_task(fptr, priority, period_ticks, stack_words);
     if (task == NULL) {
         goto fail;
     }
@@ -126,10 +163,34 @@ fail:
     panic_print("Could not allocate task with function pointer 0x%x", fptr);
 }
 
+LINKER_ARRAY_DECLARE(static_tasks)
+
+void start_static_tasks(void) {
+    const struct static_task *entry;
+
+    LINKER_ARRAY_FOR_EACH(static_tasks, entry) {
+        uint32_t period_ticks = us_to_ticks(entry->period_us);
+
+        check_priority(entry->priority);
+
+        init_task(entry->task, entry->stack, entry->stack_words, entry->fptr,
+                  entry->priority, period_ticks);
+        entry->task->static_alloc = 1;
+
+        register_task(entry->task, period_ticks);
+
+        total_tasks += 1;
+    }
+}
+
 void svc_register_task(task_ctrl *task, int periodic) {
-    insert_task(runnable_task_list, task);
+    list_add_tail(&task->all_task_list, &all_task_list);
 
     if (periodic) {
-        insert_task(periodic_task_list, task);
+        periodic_task_release(task);
+        periodic_queue_insert(task, periodic_release_ticks(task));
+    }
+    else {
+        ready_queue_insert(task);
     }
 }
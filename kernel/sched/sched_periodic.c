@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include <kernel/trace.h>
+#include "sched_internals.h"
+
+struct list periodic_task_list = INIT_LIST(periodic_task_list);
+
+/* Called when a periodic task misses a release */
+static void (*overrun_handler)(task_t *task) = NULL;
+
+void set_overrun_handler(void (*handler)(task_t *task)) {
+    overrun_handler = handler;
+}
+
+DEFINE_DELTA_QUEUE(periodic_queue, task_ctrl, periodic_task_list, ticks_until_wake)
+
+/* Release periodic tasks whose period has expired */
+void rtos_tick(void) {
+    task_ctrl *task;
+
+    periodic_queue_advance(1);
+
+    while ((task = periodic_queue_pop_expired())) {
+        /*
+         * If this task hasn't finished (or even started) since the last
+         * period edge, it will still be in the runnable task list.  Don't
+         * add it again, as this will corrupt the list.  Likewise, a task
+         * blocked mid-run will return to the scheduler when woken.
+         */
+        if (!task_runnable(get_task_t(task)) && !task->blocked) {
+            trace_record(TRACE_RELEASE, task->pid);
+            periodic_task_release(task);
+        }
+        else {
+            /* The previous job overran into this period */
+            task->overruns++;
+            trace_record(TRACE_OVERRUN, task->pid);
+
+            if (overrun_handler) {
+                overrun_handler(get_task_t(task));
+            }
+        }
+
+        periodic_queue_insert(task, periodic_release_ticks(task));
+    }
+
+    /* Tasklets are released on the same ticks */
+    tasklet_tick();
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+#include <dev/hw/perfcounter.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include "sched_internals.h"
+
+struct ready_queue ready_queue;
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+/* Runnable tasks scheduled by deadline, sorted by deadline */
+static struct list deadline_task_list = INIT_LIST(deadline_task_list);
+
+static void deadline_queue_insert(task_ctrl *task) {
+    struct list *element;
+
+    /* Insert after any tasks with the same deadline */
+    list_for_each(element, &deadline_task_list) {
+        task_ctrl *curr = list_entry(element, task_ctrl, runnable_task_list);
+
+        if (deadline_before(effective_deadline(task),
+                            effective_deadline(curr))) {
+            break;
+        }
+    }
+
+    list_insert_before(&task->runnable_task_list, element);
+}
+#endif
+
+/* Index of most significant set bit.  word must be non-zero. */
+static __always_inline uint32_t highest_bit(uint32_t word) {
+    return 31 - __builtin_clz(word);
+}
+
+void ready_queue_reinsert(task_ctrl *task) {
+    uint8_t priority = task->priority;
+    uint32_t word = priority / 32;
+    uint32_t bit = 1 << (priority % 32);
+    struct list *head = &ready_queue.tasks[priority];
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+    if (deadline_scheduled(task)) {
+        deadline_queue_insert(task);
+        return;
+    }
+#endif
+
+    /* First task at this priority, the list head is not yet valid */
+    if (!(ready_queue.bitmap[word] & bit)) {
+        list_init(head);
+        ready_queue.bitmap[word] |= bit;
+        ready_queue.group |= 1 << word;
+    }
+
+    list_add_tail(&task->runnable_task_list, head);
+}
+
+void ready_queue_insert(task_ctrl *task) {
+#ifdef CONFIG_SCHED_POLICY_EDF
+    if (task->immediate) {
+        task->deadline = system_ticks;
+    }
+#endif
+
+#ifdef CONFIG_PERFCOUNTER
+    /* For measuring latency until task runs */
+    task->ready_timestamp = perfcounter_getcount();
+#endif
+
+    ready_queue_reinsert(task);
+}
+
+void ready_queue_remove(task_ctrl *task) {
+    uint8_t priority = task->priority;
+    uint32_t word = priority / 32;
+
+    if (list_empty(&task->runnable_task_list)) {
+        return;
+    }
+
+    list_remove(&task->runnable_task_list);
+    /* Mark task as no longer runnable */
+    list_init(&task->runnable_task_list);
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+    if (deadline_scheduled(task)) {
+        return;
+    }
+#endif
+
+    if (list_empty(&ready_queue.tasks[priority])) {
+        ready_queue.bitmap[word] &= ~(1 << (priority % 32));
+
+        if (!ready_queue.bitmap[word]) {
+            ready_queue.group &= ~(1 << word);
+        }
+    }
+}
+
+int ready_queue_only(task_ctrl *task) {
+    struct list *head = &ready_queue.tasks[task->priority];
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+    if (deadline_scheduled(task)) {
+        head = &deadline_task_list;
+
+        if (ready_queue.group) {
+            return 0;
+        }
+
+        return head->next == &task->runnable_task_list
+            && head->prev == &task->runnable_task_list;
+    }
+
+    if (!list_empty(&deadline_task_list)) {
+        return 0;
+    }
+#endif
+
+    /* Only the bit for this task's priority is set */
+    if (ready_queue.group != 1 << (task->priority / 32)
+            || ready_queue.bitmap[task->priority / 32]
+                != 1 << (task->priority % 32)) {
+        return 0;
+    }
+
+    return head->next == &task->runnable_task_list
+        && head->prev == &task->runnable_task_list;
+}
+
+task_ctrl *ready_queue_next(void) {
+    uint32_t word, priority;
+    struct list *head, *element;
+
+#ifdef CONFIG_SCHED_POLICY_EDF
+    /* Periodic tasks run earliest deadline first, ahead of all others */
+    if (!list_empty(&deadline_task_list)) {
+        return list_entry(deadline_task_list.next, task_ctrl,
+                          runnable_task_list);
+    }
+#endif
+
+    if (!ready_queue.group) {
+        return NULL;
+    }
+
+    word = highest_bit(ready_queue.group);
+    priority = 32*word + highest_bit(ready_queue.bitmap[word]);
+    head = &ready_queue.tasks[priority];
+
+    /* Round-robin through equal priority tasks */
+    element = list_pop_head(head);
+    list_add_tail(element, head);
+
+    return list_entry(element, task_ctrl, runnable_task_list);
+}
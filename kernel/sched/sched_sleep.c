@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include "sched_internals.h"
+
+struct list sleep_task_list = INIT_LIST(sleep_task_list);
+
+DEFINE_DELTA_QUEUE(sleep_queue, task_ctrl, sleep_task_list, sleep_ticks)
+
+void task_block(task_t *task, uint32_t timeout_us) {
+    task_ctrl *t = get_task_ctrl(task);
+
+    ready_queue_remove(t);
+    t->blocked = 1;
+    t->timed_out = 0;
+
+    if (timeout_us != TIMEOUT_FOREVER) {
+        /*
+         * The current tick is already partly over, so wait one more than
+         * the whole ticks requested, to never wake early.
+         */
+        sleep_queue_insert(t, us_to_ticks(timeout_us) + 1);
+    }
+}
+
+void task_wake(task_t *task) {
+    task_ctrl *t = get_task_ctrl(task);
+
+    if (!t->blocked) {
+        return;
+    }
+
+    sleep_queue_remove(t);
+    t->blocked = 0;
+    ready_queue_insert(t);
+}
+
+int task_timed_out(task_t *task) {
+    return get_task_ctrl(task)->timed_out;
+}
+
+void task_wait(struct list *waiters, uint32_t timeout_us) {
+    struct task_wait_data *wait = &curr_task->wait_data;
+    struct list *element;
+
+    list_for_each(element, waiters) {
+        task_t *waiter = list_entry(element, task_t, wait_data.wait_list);
+
+        if (task_compare(curr_task, waiter) > 0) {
+            break;
+        }
+    }
+
+    list_insert_before(&wait->wait_list, element);
+    wait->status = -1;
+
+    task_block(curr_task, timeout_us);
+    svc_task_switch(NULL);
+}
+
+void task_wait_wake(task_t *task) {
+    struct task_wait_data *wait = &task->wait_data;
+
+    list_remove(&wait->wait_list);
+    list_init(&wait->wait_list);
+    wait->status = 0;
+
+    task_wake(task);
+}
+
+void sleep_queue_tick(void) {
+    task_ctrl *task;
+
+    sleep_queue_advance(1);
+
+    while ((task = sleep_queue_pop_expired())) {
+        struct list *wait_list = &get_task_t(task)->wait_data.wait_list;
+
+        /* Stop waiting on any semaphore or event group */
+        list_remove(wait_list);
+        list_init(wait_list);
+
+        task_wake(get_task_t(task));
+        task->timed_out = 1;
+    }
+}
+
+void svc_sleep(uint32_t usecs) {
+    task_block(curr_task, usecs);
+    svc_task_switch(NULL);
+}
@@ -23,6 +23,9 @@
 #include <compiler.h>
 #include <kernel/sched.h>
 #include <kernel/sched_internals.h>
+#include <kernel/static_task.h>
+#include <kernel/tasklet.h>
+#include <kernel/workqueue.h>
 #include "sched_internals.h"
 
 volatile uint8_t task_switching = 0;
@@ -31,19 +34,36 @@ volatile uint8_t task_switching = 0;
  * "Task" before task switching begins
  *
  * Used for accessing things like stdin/stdout before
- * task switching begins.
+ * task switching begins.  Also owns mutexes acquired before
+ * task switching begins, so it must never appear runnable.
  */
-static struct task_ctrl pre_switch_task;
+static struct task_ctrl pre_switch_task = {
+    .runnable_task_list = INIT_LIST(pre_switch_task.runnable_task_list),
+};
 task_t * volatile curr_task = &pre_switch_task.exported;
 
 void start_sched(void) {
     /*
      * Set up initial tasks.
      * Kernel task performs cleanup every millisecond.
+     * Worker task runs work deferred by interrupt handlers.
+     * Tasklet task runs tasklets on a shared stack.
      */
     new_task(&kernel_task, 10, 1000);
+#ifdef CONFIG_SCHED_POLICY_EDF
+    /* Periodic tasks run ahead of any priority, so the worker needs a deadline */
+    task_set_immediate_deadline(new_task(&workqueue_task, WORKQUEUE_PRIORITY, 0));
+#else
+    new_task(&workqueue_task, WORKQUEUE_PRIORITY, 0);
+#endif
+#ifdef CONFIG_TASKLETS
+    new_task(&tasklet_task, TASKLET_PRIORITY, 0);
+#endif
     new_task(&sleep_task, 0, 0);
 
+    /* Tasks defined with DEFINE_STATIC_TASK */
+    start_static_tasks();
+
     /* Setup boot tasks specified by end user. */
     main();
 
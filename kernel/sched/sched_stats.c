@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+#include <dev/hw/perfcounter.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include "sched_internals.h"
+
+struct list all_task_list = INIT_LIST(all_task_list);
+
+#ifdef CONFIG_PERFCOUNTER
+/* perfcounter count at the last task switch */
+static uint64_t last_switch;
+#endif
+
+void sched_account_switch(task_ctrl *prev, task_ctrl *next) {
+#ifdef CONFIG_PERFCOUNTER
+    uint64_t now = perfcounter_getcount();
+
+    prev->runtime += now - last_switch;
+    last_switch = now;
+
+    /* First run since becoming ready */
+    if (next->ready_timestamp) {
+        uint64_t latency = now - next->ready_timestamp;
+
+        if (latency > next->max_latency) {
+            next->max_latency = latency;
+        }
+
+        next->ready_timestamp = 0;
+    }
+#endif
+
+    if (prev != next) {
+        next->switches++;
+    }
+}
+
+/*
+ * Stack words used, found from the deepest word overwritten from STACK_PAINT.
+ * The stack guard is skipped, as it can't be read while its task runs.
+ */
+static uint32_t stack_used(task_ctrl *task) {
+    uint32_t *word = arch_sched_stack_guard_end(task);
+
+    while (word < task->stack_base && *word == STACK_PAINT) {
+        word++;
+    }
+
+    return task->stack_base - word;
+}
+
+int svc_task_stats(struct task_stats *stats, int max) {
+    task_ctrl *task;
+    int count = 0;
+
+    list_for_each_entry(task, &all_task_list, all_task_list) {
+        if (count >= max) {
+            break;
+        }
+
+        stats[count].pid = task->pid;
+        stats[count].fptr = task->fptr;
+        stats[count].priority = task->priority;
+        stats[count].period = task->period;
+        stats[count].runtime = task->runtime;
+        stats[count].max_latency = task->max_latency;
+        stats[count].switches = task->switches;
+        stats[count].overruns = task->overruns;
+        stats[count].max_response = task->max_response;
+        stats[count].stack_size = task->stack_base - task->stack_limit;
+        stats[count].stack_used = stack_used(task);
+
+        count++;
+    }
+
+    return count;
+}
+
+int task_stats(struct task_stats *stats, int max) {
+    if (!task_switching || !arch_svc_legal()) {
+        return -1;
+    }
+
+    return SVC_ARG2(SVC_TASK_STATS, stats, max);
+}
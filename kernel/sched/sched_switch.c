@@ -21,48 +21,52 @@
  */
 
 #include <stddef.h>
+#include <compiler.h>
 #include <kernel/fault.h>
 
 #include <kernel/sched.h>
 #include <kernel/sched_internals.h>
+#include <kernel/trace.h>
 #include "sched_internals.h"
 
+/* Switch requested with arch_sched_pend_switch(), not yet performed */
+static uint8_t switch_pending = 0;
+static task_ctrl *pending_task = NULL;
+
 void switch_task(task_ctrl *task) {
     /* Optionally pass task to switch to, otherwise pass NULL */
 
     /* Rate monotonic scheduling
      * Always runs the highest priority task,
-     * which will be the head of the list, as
-     * it is kept sorted.  Round-robin through
-     * equal priority tasks. */
+     * selected from the ready queue bitmap.
+     * Round-robin through equal priority tasks. */
 
     if (task == NULL) {
-        if (list_empty(&runnable_task_list)) {
+        task = ready_queue_next();
+        if (!task) {
             /* Uh-oh, no tasks! */
             panic_print("No tasks to run.");
         }
+    }
 
-        struct list *element = list_pop_head(&runnable_task_list);
-        task = list_entry(element, task_ctrl, runnable_task_list);
-
-        curr_task = get_task_t(task);
+    /* Any pended switch is superseded by this one */
+    switch_pending = 0;
+    pending_task = NULL;
 
-        /* As a workaround for lack of MPU support, check if the
-         * stack of the task we are switching from has overflowed */
-        if (task->stack_limit > task->stack_top) {
-            panic_print("Task (0x%x, fptr: 0x%x) has overflowed its stack. "
-                        "stack_top: 0x%x stack_limit: 0x%x", task, task->fptr,
-                        task->stack_top, task->stack_limit);
-        }
+    trace_record(TRACE_SWITCH, task->pid);
+    sched_account_switch(get_task_ctrl(curr_task), task);
+    curr_task = get_task_t(task);
 
-        insert_task(runnable_task_list, task);
-    }
-    else {
-        curr_task = get_task_t(task);
+    /*
+     * If the arch can't fault on stack overflow, check if the stack of
+     * the task we are switching to has overflowed.
+     */
+    if (!arch_sched_stack_guard(task) && task->stack_limit > task->stack_top) {
+        panic_print("Task (0x%x, fptr: 0x%x) has overflowed its stack. "
+                    "stack_top: 0x%x stack_limit: 0x%x", task, task->fptr,
+                    task->stack_top, task->stack_limit);
     }
 
-    /* mpu_stack_set(task->stack_base);   Sigh...maybe some day */
-
     if (!task->running) {
         task->running = 1;
         create_context(task, &end_task);
@@ -72,6 +76,8 @@ void switch_task(task_ctrl *task) {
 }
 
 int svc_task_switch(task_ctrl *task) {
+    uint8_t first = 0;
+
     if (task && !task_runnable(get_task_t(task))) {
         return -1;
     }
@@ -93,8 +99,24 @@ int svc_task_switch(task_ctrl *task) {
         arch_sched_start_system_tick();
 
         task_switching = 1;
+        first = 1;
+    }
+
+    /*
+     * If the arch can, it performs the switch once no other handler is
+     * active.  Requests made until then collapse into one switch, and a
+     * request for a particular task is kept over a request for any task.
+     */
+    if (arch_sched_pend_switch()) {
+        if (task || !switch_pending) {
+            pending_task = task;
+        }
+
+        switch_pending = 1;
+        return 0;
     }
-    else {
+
+    if (!first) {
         get_task_ctrl(curr_task)->stack_top = get_user_stack_pointer();
     }
 
@@ -102,24 +124,32 @@ int svc_task_switch(task_ctrl *task) {
     return 0;
 }
 
-/* Updates ticks in all periodic tasks */
-void rtos_tick(void) {
-    task_ctrl *task;
-
-    list_for_each_entry(task, &periodic_task_list, periodic_task_list) {
-        if (task->ticks_until_wake == 0) {
-            /*
-             * If this task hasn't finished (or even started) since the last
-             * period edge, it will still be in the runnable task list.  Don't
-             * add it again, as this will corrupt the list.
-             */
-            if (!task_runnable(get_task_t(task))) {
-                insert_task(runnable_task_list, task);
-            }
-            task->ticks_until_wake = task->period;
-        }
-        else {
-            task->ticks_until_wake--;
-        }
+void sched_pended_switch(void) {
+    task_ctrl *task = pending_task;
+
+    if (!switch_pending) {
+        return;
+    }
+
+    /* The requested task may have blocked since */
+    if (task && !task_runnable(get_task_t(task))) {
+        task = NULL;
     }
+
+    get_task_ctrl(curr_task)->stack_top = get_user_stack_pointer();
+    switch_task(task);
+}
+
+/* By default, switch immediately */
+int __weak arch_sched_pend_switch(void) {
+    return 0;
+}
+
+/* By default, check for stack overflow in software */
+int __weak arch_sched_stack_guard(task_ctrl *task) {
+    return 0;
+}
+
+uint32_t * __weak arch_sched_stack_guard_end(task_ctrl *task) {
+    return task->stack_limit;
 }
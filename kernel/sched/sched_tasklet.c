@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic.h>
+#include <list.h>
+#include <kernel/event.h>
+#include <kernel/fault.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include <kernel/tasklet.h>
+#include "sched_internals.h"
+
+#define TASKLET_RELEASED    (1 << 0)
+
+struct list tasklet_queue = INIT_LIST(tasklet_queue);
+
+DEFINE_DELTA_QUEUE(tasklet_queue, struct tasklet, tasklet_queue, ticks_until_release)
+
+/*
+ * Released tasklets, most recently released first.  Pushed with LL/SC, and
+ * taken whole by the tasklet task.
+ */
+static struct tasklet *volatile released_list = NULL;
+static struct event_group tasklet_event = INIT_EVENT_GROUP(tasklet_event);
+
+static int start(struct tasklet *tasklet, uint32_t delay_us) __attribute__((section(".kernel")));
+static int stop(struct tasklet *tasklet) __attribute__((section(".kernel")));
+
+static void tasklet_release(struct tasklet *tasklet) {
+    struct tasklet *head;
+
+    /* Still waiting to run from a previous release */
+    if (atomic_spin_swap(&tasklet->pending, 1)) {
+        tasklet->overruns++;
+        return;
+    }
+
+    do {
+        head = (struct tasklet *)
+            load_link32((volatile uint32_t *) &released_list);
+        tasklet->next = head;
+    } while (store_conditional32((volatile uint32_t *) &released_list,
+                                 (uint32_t) tasklet));
+
+    event_set(&tasklet_event, TASKLET_RELEASED);
+}
+
+/* Release tasklets whose delay has expired */
+void tasklet_tick(void) {
+    struct tasklet *tasklet;
+
+    tasklet_queue_advance(1);
+
+    while ((tasklet = tasklet_queue_pop_expired())) {
+        tasklet_release(tasklet);
+
+        if (tasklet->period) {
+            tasklet_queue_insert(tasklet, tasklet->period);
+        }
+    }
+}
+
+static int stop(struct tasklet *tasklet) {
+    int started = !list_empty(&tasklet->tasklet_queue);
+
+    tasklet_queue_remove(tasklet);
+
+    return started;
+}
+
+static int start(struct tasklet *tasklet, uint32_t delay_us) {
+    uint32_t delay = us_to_ticks(delay_us);
+    int started = stop(tasklet);
+
+    tasklet->period = us_to_ticks(tasklet->period_us);
+
+    /* Released on a later tick, never the current one */
+    tasklet_queue_insert(tasklet, delay ? delay : 1);
+
+    return started;
+}
+
+int tasklet_start(struct tasklet *tasklet, uint32_t delay_us) {
+    if (task_switching && arch_svc_legal()) {
+        return SVC_ARG2(SVC_TASKLET_START, tasklet, delay_us);
+    }
+
+    /*
+     * Interrupt context, or before task switching.  Interrupts do not
+     * preempt service calls, or each other, so the queue can be updated
+     * directly.
+     */
+    return start(tasklet, delay_us);
+}
+
+int tasklet_stop(struct tasklet *tasklet) {
+    if (task_switching && arch_svc_legal()) {
+        return SVC_ARG(SVC_TASKLET_STOP, tasklet);
+    }
+
+    return stop(tasklet);
+}
+
+void tasklet_task(void) {
+    while (1) {
+        struct tasklet *list, *ordered = NULL;
+
+        list = (struct tasklet *)
+            atomic_spin_swap((uint32_t *) &released_list, 0);
+        if (!list) {
+            event_wait(&tasklet_event, TASKLET_RELEASED,
+                       EVENT_WAIT_ANY | EVENT_WAIT_CLEAR, TIMEOUT_FOREVER,
+                       NULL);
+            continue;
+        }
+
+        /* Reverse, to run tasklets in the order they were released */
+        while (list) {
+            struct tasklet *next = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next;
+        }
+
+        while (ordered) {
+            struct tasklet *tasklet = ordered;
+            ordered = tasklet->next;
+
+            /* tasklet->next is no longer needed, so it may be released */
+            tasklet->pending = 0;
+            smp_mb();
+
+            tasklet->func(tasklet);
+        }
+    }
+}
+
+int tasklet_service_call(uint32_t svc_number, ...) {
+    int ret = 0;
+    va_list ap;
+    va_start(ap, svc_number);
+
+    switch (svc_number) {
+        case SVC_TASKLET_START: {
+            struct tasklet *tasklet = va_arg(ap, struct tasklet *);
+            uint32_t delay_us = va_arg(ap, uint32_t);
+            ret = start(tasklet, delay_us);
+            break;
+        }
+        case SVC_TASKLET_STOP: {
+            struct tasklet *tasklet = va_arg(ap, struct tasklet *);
+            ret = stop(tasklet);
+            break;
+        }
+        default:
+            panic_print("Unknown SVC: %d", svc_number);
+            break;
+    }
+
+    va_end(ap);
+
+    return ret;
+}
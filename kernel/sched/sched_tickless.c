@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <kernel/power.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include "sched_internals.h"
+
+void tickless_idle(void) {
+    task_ctrl *idle = get_task_ctrl(curr_task);
+    uint32_t ticks, sleep_ticks, tasklet_ticks, elapsed;
+
+    /*
+     * With interrupts masked, no other task can become runnable between
+     * checking the ready queue and suppressing ticks.  Pending interrupts
+     * still wake the core, and are taken once unmasked.
+     */
+    arch_sched_mask_interrupts();
+
+    ticks = periodic_queue_next();
+    sleep_ticks = sleep_queue_next();
+    if (sleep_ticks < ticks) {
+        ticks = sleep_ticks;
+    }
+    tasklet_ticks = tasklet_queue_next();
+    if (tasklet_ticks < ticks) {
+        ticks = tasklet_ticks;
+    }
+
+    /*
+     * Nothing to gain if the next tick is already a release or timeout.
+     * The arch may also be unable to suppress ticks right now.
+     */
+    if (!ready_queue_only(idle) || ticks <= 1
+            || !arch_sched_suppress_ticks(ticks)) {
+        arch_wait_for_interrupt();
+        arch_sched_unmask_interrupts();
+        return;
+    }
+
+    arch_wait_for_interrupt();
+
+    /*
+     * Account for the skipped ticks.  The tick that ends the suppression,
+     * if it has occurred, is still pending, and is handled normally.
+     */
+    elapsed = arch_sched_resume_ticks();
+    clock_advance(elapsed);
+    periodic_queue_advance(elapsed);
+    sleep_queue_advance(elapsed);
+    tasklet_queue_advance(elapsed);
+
+    arch_sched_unmask_interrupts();
+}
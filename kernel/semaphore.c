@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <list.h>
+#include <kernel/fault.h>
+#include <kernel/sched.h>
+#include <kernel/semaphore.h>
+
+static int svc_sem_wait(struct semaphore *sem, uint32_t timeout_us) __attribute__((section(".kernel")));
+static task_t *post(struct semaphore *sem) __attribute__((section(".kernel")));
+
+/* Result is returned in curr_task->wait_data.status */
+static int svc_sem_wait(struct semaphore *sem, uint32_t timeout_us) {
+    if (sem->count) {
+        sem->count--;
+        curr_task->wait_data.status = 0;
+        return 0;
+    }
+
+    if (!timeout_us) {
+        curr_task->wait_data.status = -1;
+        return 0;
+    }
+
+    /* Woken by post(), which hands us the count directly */
+    task_wait(&sem->waiters, timeout_us);
+
+    return 0;
+}
+
+/* Returns the task woken, if any */
+static task_t *post(struct semaphore *sem) {
+    task_t *waiter;
+
+    if (list_empty(&sem->waiters)) {
+        sem->count++;
+        return NULL;
+    }
+
+    waiter = list_entry(sem->waiters.next, task_t, wait_data.wait_list);
+    task_wait_wake(waiter);
+
+    return waiter;
+}
+
+int sem_wait(struct semaphore *sem, uint32_t timeout_us) {
+    PANIC_ON(!arch_svc_legal());
+
+    /* Nothing else can post before task switching, so don't block */
+    if (!task_switching) {
+        svc_sem_wait(sem, 0);
+    }
+    else {
+        SVC_ARG2(SVC_SEM_WAIT, sem, timeout_us);
+    }
+
+    return curr_task->wait_data.status;
+}
+
+void sem_post(struct semaphore *sem) {
+    if (task_switching && arch_svc_legal()) {
+        SVC_ARG(SVC_SEM_POST, sem);
+    }
+    else {
+        /*
+         * Interrupt context, or before task switching.  Interrupts do not
+         * preempt service calls, so the semaphore can be updated directly.
+         * From an interrupt, the switch is pended until handlers return.
+         */
+        task_t *waiter = post(sem);
+
+        if (task_switching && waiter && task_compare(waiter, curr_task) > 0) {
+            task_switch(NULL);
+        }
+    }
+}
+
+int semaphore_service_call(uint32_t svc_number, ...) {
+    int ret = 0;
+    va_list ap;
+    va_start(ap, svc_number);
+
+    switch (svc_number) {
+        case SVC_SEM_WAIT: {
+            struct semaphore *sem = va_arg(ap, struct semaphore *);
+            uint32_t timeout_us = va_arg(ap, uint32_t);
+            ret = svc_sem_wait(sem, timeout_us);
+            break;
+        }
+        case SVC_SEM_POST: {
+            struct semaphore *sem = va_arg(ap, struct semaphore *);
+            task_t *waiter = post(sem);
+
+            if (waiter && task_compare(waiter, curr_task) > 0) {
+                task_switch(NULL);
+            }
+            break;
+        }
+        default:
+            panic_print("Unknown SVC: %d", svc_number);
+            break;
+    }
+
+    va_end(ap);
+
+    return ret;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include <kernel/trace.h>
+
+/* Index by masking the free running event count */
+typedef char trace_events_is_power_of_two[
+    (CONFIG_SCHED_TRACE_EVENTS & (CONFIG_SCHED_TRACE_EVENTS - 1)) ? -1 : 1];
+
+static struct trace_event trace_buffer[CONFIG_SCHED_TRACE_EVENTS];
+
+/* Total events recorded since start */
+static uint32_t trace_head = 0;
+static volatile uint8_t trace_enabled = 1;
+
+void trace_record(uint8_t type, uint32_t arg) {
+    struct trace_event *event;
+
+    if (!trace_enabled) {
+        return;
+    }
+
+    event = &trace_buffer[trace_head++ & (CONFIG_SCHED_TRACE_EVENTS - 1)];
+
+    event->timestamp = arch_trace_timestamp();
+    event->arg = arg;
+    event->pid = curr_task ? get_task_ctrl(curr_task)->pid : 0;
+    event->type = type;
+    event->reserved = 0;
+}
+
+/*
+ * Tasks only run once all handlers have returned, so once these return,
+ * no event is partially recorded.
+ */
+void trace_start(void) {
+    trace_enabled = 0;
+    trace_head = 0;
+    trace_enabled = 1;
+}
+
+void trace_stop(void) {
+    trace_enabled = 0;
+}
+
+uint32_t trace_count(void) {
+    if (trace_head > CONFIG_SCHED_TRACE_EVENTS) {
+        return CONFIG_SCHED_TRACE_EVENTS;
+    }
+
+    return trace_head;
+}
+
+int trace_read(struct trace_event *events, uint32_t start, int max) {
+    uint32_t count = trace_count();
+    uint32_t oldest = trace_head - count;
+    int copied = 0;
+
+    while (copied < max && start + copied < count) {
+        uint32_t index = (oldest + start + copied) &
+                         (CONFIG_SCHED_TRACE_EVENTS - 1);
+
+        events[copied] = trace_buffer[index];
+        copied++;
+    }
+
+    return copied;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic.h>
+#include <kernel/event.h>
+#include <kernel/sched.h>
+#include <kernel/workqueue.h>
+
+#define WORK_QUEUED     (1 << 0)
+
+/*
+ * Queued work, most recently queued first.  Pushed with LL/SC, so
+ * interrupts may queue work at any point, and taken whole by the worker.
+ */
+static struct work *volatile work_list = NULL;
+static struct event_group work_event = INIT_EVENT_GROUP(work_event);
+
+int queue_work(struct work *work) {
+    struct work *head;
+
+    /* Only the first caller queues work, until it starts running */
+    if (atomic_spin_swap(&work->pending, 1)) {
+        return 1;
+    }
+
+    do {
+        head = (struct work *) load_link32((volatile uint32_t *) &work_list);
+        work->next = head;
+    } while (store_conditional32((volatile uint32_t *) &work_list,
+                                 (uint32_t) work));
+
+    event_set(&work_event, WORK_QUEUED);
+
+    return 0;
+}
+
+void workqueue_task(void) {
+    while (1) {
+        struct work *list, *ordered = NULL;
+
+        list = (struct work *) atomic_spin_swap((uint32_t *) &work_list, 0);
+        if (!list) {
+            event_wait(&work_event, WORK_QUEUED,
+                       EVENT_WAIT_ANY | EVENT_WAIT_CLEAR, TIMEOUT_FOREVER,
+                       NULL);
+            continue;
+        }
+
+        /* Reverse, to run work in the order it was queued */
+        while (list) {
+            struct work *next = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next;
+        }
+
+        while (ordered) {
+            struct work *work = ordered;
+            ordered = work->next;
+
+            /* work->next is no longer needed, so it may be requeued */
+            work->pending = 0;
+            smp_mb();
+
+            work->func(work);
+        }
+    }
+}
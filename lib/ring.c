@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic.h>
+#include <ring.h>
+
+int init_ring(struct ring *ring, uint8_t *buffer, uint32_t len) {
+    if (len & (len - 1)) {
+        return -1;
+    }
+
+    ring->buf = buffer;
+    ring->size = len;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return 0;
+}
+
+size_t ring_write_peek(struct ring *ring, uint8_t **ptr) {
+    uint32_t head = ring->head;
+    uint32_t space = ring->size - (head - ring->tail);
+    uint32_t offset = head & (ring->size - 1);
+    uint32_t contiguous = ring->size - offset;
+
+    /* The consumer must be done with the space before we reuse it */
+    smp_mb();
+
+    *ptr = &ring->buf[offset];
+
+    return space < contiguous ? space : contiguous;
+}
+
+void ring_write_commit(struct ring *ring, size_t len) {
+    /* Data must be visible before the consumer can see it is there */
+    smp_wmb();
+
+    ring->head += len;
+}
+
+size_t ring_read_peek(struct ring *ring, uint8_t **ptr) {
+    uint32_t tail = ring->tail;
+    uint32_t used = ring->head - tail;
+    uint32_t offset = tail & (ring->size - 1);
+    uint32_t contiguous = ring->size - offset;
+
+    /* Don't read data older than the head that published it */
+    smp_rmb();
+
+    *ptr = &ring->buf[offset];
+
+    return used < contiguous ? used : contiguous;
+}
+
+void ring_read_commit(struct ring *ring, size_t len) {
+    /* Finish reading the data before the producer may overwrite it */
+    smp_mb();
+
+    ring->tail += len;
+}
+
+size_t ring_write(struct ring *ring, const void *data, size_t len) {
+    const uint8_t *src = data;
+    size_t total = 0;
+
+    /* At most two regions: up to the end of the buffer, then from the start */
+    for (int i = 0; i < 2 && total < len; i++) {
+        uint8_t *dst;
+        size_t chunk = ring_write_peek(ring, &dst);
+
+        if (!chunk) {
+            break;
+        }
+
+        if (chunk > len - total) {
+            chunk = len - total;
+        }
+
+        memcpy(dst, &src[total], chunk);
+        ring_write_commit(ring, chunk);
+        total += chunk;
+    }
+
+    return total;
+}
+
+size_t ring_read(struct ring *ring, void *data, size_t len) {
+    uint8_t *dst = data;
+    size_t total = 0;
+
+    for (int i = 0; i < 2 && total < len; i++) {
+        uint8_t *src;
+        size_t chunk = ring_read_peek(ring, &src);
+
+        if (!chunk) {
+            break;
+        }
+
+        if (chunk > len - total) {
+            chunk = len - total;
+        }
+
+        memcpy(&dst[total], src, chunk);
+        ring_read_commit(ring, chunk);
+        total += chunk;
+    }
+
+    return total;
+}
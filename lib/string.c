@@ -60,18 +60,31 @@ int memcmp(const void *ptr1, const void *ptr2, size_t num) {
     return 0;
 }
 
-/* Set size bytes to value from p */
+/*
+ * Set size bytes to the word value from p, a word at a time.
+ * size is rounded down to a multiple of 4 bytes.
+ */
 void memset32(void *p, int32_t value, uint32_t size) {
-    uint32_t *end = (uint32_t *) ((uintptr_t) p + size);
+    uint32_t *word = p;
+    uint32_t words = size / 4;
 
     /* Disallowed unaligned addresses */
     if ( (uintptr_t) p % 4 ) {
         panic_print("Attempt to memset unaligned address (0x%x).", p);
     }
 
-    while ( (uint32_t*) p < end ) {
-        *((uint32_t*)p) = value;
-        p++;
+    /* Unrolled, so large areas like stacks spend less time on the loop */
+    while (words >= 4) {
+        word[0] = value;
+        word[1] = value;
+        word[2] = value;
+        word[3] = value;
+        word += 4;
+        words -= 4;
+    }
+
+    while (words--) {
+        *word++ = value;
     }
 }
 
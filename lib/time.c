@@ -20,13 +20,37 @@
  * SOFTWARE.
  */
 
+#include <atomic.h>
 #include <stdint.h>
 #include <time.h>
 #include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+
+/* Nanoseconds per system tick */
+#define TICK_NS     (NSEC_PER_SEC / CONFIG_SYSTICK_FREQ)
 
 volatile uint32_t system_ticks = 0;
 
+/*
+ * 64-bit count of system ticks, which doesn't wrap like system_ticks.
+ *
+ * A seqlock: clock_seq is odd while clock_ticks is updated, so readers
+ * retry if they see an odd or changed clock_seq.  Readers never block the
+ * tick, and only retry if a tick occurs while reading.
+ */
+static volatile uint32_t clock_seq = 0;
+static volatile uint64_t clock_ticks = 0;
+
 int usleep(uint32_t usecs) {
+    if (!usecs) {
+        return 0;
+    }
+
+    /* Block in the scheduler, rather than spinning, when possible */
+    if (!task_sleep(usecs)) {
+        return 0;
+    }
+
     uint64_t start = system_time(0);
 
     while (system_time(start) < usecs) {
@@ -37,13 +61,51 @@ int usleep(uint32_t usecs) {
 }
 
 uint64_t system_time(uint64_t start_time) {
-    uint32_t local_sys_ticks = system_ticks;
-
-    /* Tick period in usecs */
-    uint64_t period = 1e6/CONFIG_SYSTICK_FREQ;
-
     /* usec since boot */
-    uint64_t current_time = local_sys_ticks * period;
+    uint64_t current_time = clock_monotonic_ns() / 1000;
 
     return current_time - start_time;
 }
+
+void clock_advance(uint32_t ticks) {
+    clock_seq++;
+    smp_wmb();
+
+    clock_ticks += ticks;
+    system_ticks += ticks;
+
+    smp_wmb();
+    clock_seq++;
+}
+
+uint64_t clock_monotonic_ns(void) {
+    uint32_t seq, elapsed;
+    uint64_t ticks;
+
+    do {
+        seq = clock_seq;
+        smp_rmb();
+
+        ticks = clock_ticks;
+        elapsed = arch_sched_tick_elapsed_ns();
+
+        smp_rmb();
+    } while ((seq & 1) || seq != clock_seq);
+
+    return ticks * TICK_NS + elapsed;
+}
+
+int clock_gettime(int clock_id, struct timespec *tp) {
+    uint64_t ns;
+
+    if (clock_id != CLOCK_MONOTONIC || !tp) {
+        return -1;
+    }
+
+    ns = clock_monotonic_ns();
+
+    tp->tv_sec = ns / NSEC_PER_SEC;
+    tp->tv_nsec = ns % NSEC_PER_SEC;
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+import gdb
+
+# Must match STACK_PAINT in kernel/sched/sched_internals.h
+STACK_PAINT = 0xa5a5a5a5
+
+class Stack_Usage(gdb.Command):
+    """Prints the stack size and high-water mark of each F4OS task"""
+
+    def __init__(self):
+        super(Stack_Usage, self).__init__("stack-usage", gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        head = gdb.parse_and_eval("all_task_list")
+        task_ptr = gdb.lookup_type("task_ctrl").pointer()
+        offset = self.offsetof("task_ctrl", "all_task_list")
+
+        total_size = 0
+        total_free = 0
+
+        print("PID\tTASK\t\tFPTR\t\t\tSIZE\tUSED\tFREE")
+
+        node = head['next']
+        while node != head.address:
+            task = gdb.Value(int(node) - offset).cast(task_ptr)
+            size, used = self.stack_usage(task)
+
+            print("%d\t0x%x\t%s\t%d\t%d\t%d" % (int(task['pid']), int(task),
+                  task['fptr'], size, used, size - used))
+
+            total_size += size
+            total_free += size - used
+            node = node['next']
+
+        print("Total: %d bytes of stack, %d bytes never used" %
+              (total_size, total_free))
+
+    def offsetof(self, struct, field):
+        zero = gdb.Value(0).cast(gdb.lookup_type(struct).pointer())
+        return int(zero[field].address)
+
+    # Size and high-water mark, in bytes
+    def stack_usage(self, task):
+        limit = int(task['stack_limit'])
+        base = int(task['stack_base'])
+        size = base - limit
+
+        # Debugger accesses aren't subject to the MPU stack guard
+        memory = gdb.selected_inferior().read_memory(limit, size)
+        data = bytes(memory)
+
+        unused = 0
+        while unused < size:
+            word = sum(ord(data[unused + i:unused + i + 1]) << (8 * i)
+                       for i in range(4))
+            if word != STACK_PAINT:
+                break
+            unused += 4
+
+        return size, size - unused
+
+Stack_Usage()
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Decode a scheduler trace written by the F4OS "trace dump" shell command.
+# See include/kernel/trace.h for the format.
+#
+# Usage: trace_decode.py <capture file>
+#
+# The capture may contain other console output before the trace, which is
+# skipped up to the trace magic.
+
+import struct
+import sys
+
+TRACE_MAGIC = b"F4TR"
+TRACE_VERSION = 1
+
+HEADER = struct.Struct("<4sBBHII")
+EVENT = struct.Struct("<IIHBB")
+
+# enum trace_type
+TYPES = {
+    1: "switch",
+    2: "svc",
+    3: "isr_enter",
+    4: "isr_exit",
+    5: "mutex_block",
+    6: "mutex_unblock",
+    7: "release",
+    8: "overrun",
+}
+
+def describe(type_name, arg):
+    if type_name in ("switch", "release", "overrun"):
+        return "pid %d" % arg
+    elif type_name == "svc":
+        return "svc %d" % arg
+    elif type_name in ("isr_enter", "isr_exit"):
+        return "exception %d" % arg
+    elif type_name in ("mutex_block", "mutex_unblock"):
+        return "mutex 0x%08x" % arg
+    return "arg 0x%08x" % arg
+
+def decode(data):
+    start = data.find(TRACE_MAGIC)
+    if start < 0:
+        raise ValueError("no trace found")
+
+    magic, version, event_size, _, hz, count = HEADER.unpack_from(data, start)
+    if version != TRACE_VERSION:
+        raise ValueError("unsupported trace version %d" % version)
+    if event_size != EVENT.size:
+        raise ValueError("unexpected event size %d" % event_size)
+
+    offset = start + HEADER.size
+    if len(data) - offset < count * event_size:
+        count = (len(data) - offset) // event_size
+        sys.stderr.write("Trace truncated, decoding %d events\n" % count)
+
+    # Timestamps are a free running 32-bit count, so accumulate deltas
+    time = 0
+    last = None
+
+    print("%12s %10s %5s  %-14s %s" % ("TIME (us)", "DELTA (us)", "PID",
+                                       "EVENT", "ARG"))
+
+    for i in range(count):
+        timestamp, arg, pid, type_id, _ = EVENT.unpack_from(data, offset)
+        offset += event_size
+
+        delta = 0
+        if last is not None:
+            delta = (timestamp - last) & 0xffffffff
+        last = timestamp
+        time += delta
+
+        type_name = TYPES.get(type_id, "unknown(%d)" % type_id)
+
+        print("%12.3f %10.3f %5d  %-14s %s" % (time * 1e6 / hz,
+                                               delta * 1e6 / hz, pid,
+                                               type_name,
+                                               describe(type_name, arg)))
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write("Usage: %s <capture file>\n" % sys.argv[0])
+        sys.exit(1)
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    try:
+        decode(data)
+    except ValueError as e:
+        sys.stderr.write("%s\n" % e)
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <dev/hw/perfcounter.h>
+#include <kernel/mutex.h>
+#include <kernel/svc.h>
+#include "app.h"
+
+/*
+ * Mutex benchmark
+ *
+ * Reports the average cost of an uncontended acquire/release pair, both
+ * through the normal API, which stays in the calling task, and forced
+ * through the kernel service calls, as every pair did before the fast path.
+ */
+
+#define PAIRS_PER_RUN   1000
+
+static struct mutex perf_mutex = INIT_MUTEX;
+
+static void report(const char *name, uint64_t start, uint64_t end) {
+    uint32_t cycles = (uint32_t) (end - start);
+
+    printf("%s: %u cycles/pair (%fus)\r\n", name, cycles / PAIRS_PER_RUN,
+           (cycles / (float) PAIRS_PER_RUN) / (CONFIG_SYS_CLOCK / 1e6));
+}
+
+void mutex_perf(int argc, char **argv) {
+    uint64_t start, end;
+
+    printf("MUTEX BENCHMARKS\r\n");
+
+    start = perfcounter_getcount();
+    for (int i = 0; i < PAIRS_PER_RUN; i++) {
+        acquire(&perf_mutex);
+        release(&perf_mutex);
+    }
+    end = perfcounter_getcount();
+
+    report("Fast path", start, end);
+
+    start = perfcounter_getcount();
+    for (int i = 0; i < PAIRS_PER_RUN; i++) {
+        SVC_ARG(SVC_ACQUIRE, &perf_mutex);
+        SVC_ARG(SVC_RELEASE, &perf_mutex);
+    }
+    end = perfcounter_getcount();
+
+    report("Service call", start, end);
+}
+DEFINE_APP(mutex_perf)
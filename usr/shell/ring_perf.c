@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <ring.h>
+#include <dev/hw/perfcounter.h>
+#include "app.h"
+
+/*
+ * Ring buffer benchmark
+ *
+ * Reports throughput of streaming data through a ring, written and read
+ * back in bulk, one byte at a time, and in place through peek/commit.
+ */
+
+#define RING_PERF_SIZE      512
+#define RING_PERF_BYTES     (64*1024)
+#define RING_PERF_CHUNK     64
+
+DEFINE_RING(perf_ring, RING_PERF_SIZE);
+
+static uint8_t chunk[RING_PERF_CHUNK];
+
+static void report(const char *name, uint64_t start, uint64_t end) {
+    uint32_t cycles = (uint32_t) (end - start);
+    float us = cycles / (CONFIG_SYS_CLOCK / 1e6);
+
+    printf("%s: %u cycles/byte (%f MB/s)\r\n", name, cycles / RING_PERF_BYTES,
+           RING_PERF_BYTES / us);
+}
+
+void ring_perf(int argc, char **argv) {
+    uint64_t start, end;
+
+    printf("RING BENCHMARKS\r\n");
+
+    start = perfcounter_getcount();
+    for (int i = 0; i < RING_PERF_BYTES; i += RING_PERF_CHUNK) {
+        ring_write(&perf_ring, chunk, RING_PERF_CHUNK);
+        ring_read(&perf_ring, chunk, RING_PERF_CHUNK);
+    }
+    end = perfcounter_getcount();
+
+    report("Bulk", start, end);
+
+    start = perfcounter_getcount();
+    for (int i = 0; i < RING_PERF_BYTES; i++) {
+        ring_write(&perf_ring, chunk, 1);
+        ring_read(&perf_ring, chunk, 1);
+    }
+    end = perfcounter_getcount();
+
+    report("Byte", start, end);
+
+    start = perfcounter_getcount();
+    for (int i = 0; i < RING_PERF_BYTES; ) {
+        uint8_t *region;
+        size_t num = ring_write_peek(&perf_ring, &region);
+
+        if (num > RING_PERF_CHUNK) {
+            num = RING_PERF_CHUNK;
+        }
+
+        /* Fill in place, as a driver would from a peripheral FIFO */
+        for (int j = 0; j < num; j++) {
+            region[j] = j;
+        }
+        ring_write_commit(&perf_ring, num);
+
+        num = ring_read_peek(&perf_ring, &region);
+        ring_read_commit(&perf_ring, num);
+
+        i += num;
+    }
+    end = perfcounter_getcount();
+
+    report("Peek/commit", start, end);
+}
+DEFINE_APP(ring_perf)
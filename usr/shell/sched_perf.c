@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <dev/hw/perfcounter.h>
+#include <kernel/sched.h>
+#include "app.h"
+
+/*
+ * Context switch benchmark
+ *
+ * Runs a round-robin ring of equal priority tasks, each yielding in turn,
+ * and reports the average cost of a single task switch as the number of
+ * tasks in the ring grows.
+ */
+
+#define YIELDS_PER_RUN  100
+#define MAX_TASKS       64
+
+/* Priority of the shell task, so that the ring tasks round-robin with it */
+#define RING_PRIORITY   1
+
+static volatile int ring_done;
+static atomic_t ring_tasks;
+
+static void ring_task(void) {
+    while (!ring_done) {
+        yield_if_possible();
+    }
+
+    atomic_dec(&ring_tasks);
+}
+
+void sched_perf(int argc, char **argv) {
+    printf("SCHEDULER BENCHMARKS\r\n");
+
+    for (int n = 4; n <= MAX_TASKS; n *= 2) {
+        uint64_t start, end;
+
+        ring_done = 0;
+        atomic_set(&ring_tasks, n - 1);
+
+        /* This task completes the ring */
+        for (int i = 0; i < n - 1; i++) {
+            new_task(&ring_task, RING_PRIORITY, 0);
+        }
+
+        /* Let all of the ring tasks start running */
+        yield_if_possible();
+
+        start = perfcounter_getcount();
+        for (int i = 0; i < YIELDS_PER_RUN; i++) {
+            yield_if_possible();
+        }
+        end = perfcounter_getcount();
+
+        ring_done = 1;
+        while (atomic_read(&ring_tasks)) {
+            yield_if_possible();
+        }
+
+        uint32_t switches = YIELDS_PER_RUN * n;
+        uint32_t cycles = (uint32_t) (end - start);
+
+        printf("%d tasks: %u cycles/switch (%fus)\r\n", n, cycles / switches,
+               (cycles / (float) switches) / (CONFIG_SYS_CLOCK / 1e6));
+    }
+}
+DEFINE_APP(sched_perf)
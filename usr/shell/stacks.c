@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <kernel/sched.h>
+#include "app.h"
+
+#define STACKS_MAX_TASKS    32
+
+static struct task_stats stats[STACKS_MAX_TASKS];
+
+/* Display stack size and high-water mark by task, in bytes */
+void stacks(int argc, char **argv) {
+    uint32_t total_size = 0, total_free = 0;
+    int count;
+
+    count = task_stats(stats, STACKS_MAX_TASKS);
+    if (count < 0) {
+        printf("Unable to get task statistics\r\n");
+        return;
+    }
+
+    printf("PID\tFPTR\t\tSIZE\tUSED\tFREE\tUSED%%\r\n");
+
+    for (int i = 0; i < count; i++) {
+        uint32_t size = stats[i].stack_size * sizeof(uint32_t);
+        uint32_t used = stats[i].stack_used * sizeof(uint32_t);
+
+        printf("%u\t0x%x\t%u\t%u\t%u\t%u%%\r\n", stats[i].pid,
+               stats[i].fptr, size, used, size - used,
+               size ? used * 100 / size : 0);
+
+        total_size += size;
+        total_free += size - used;
+    }
+
+    printf("Total: %u bytes of stack, %u bytes never used\r\n",
+           total_size, total_free);
+}
+DEFINE_APP(stacks)
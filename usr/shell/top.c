@@ -22,13 +22,93 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
+#include <dev/hw/perfcounter.h>
 #include <kernel/mutex.h>
+#include <kernel/sched.h>
 #include <mm/mm.h>
 #include "app.h"
 
-/* Display memory usage */
+#define TOP_MAX_TASKS   32
+
+/* Interval to measure CPU usage over */
+#define SAMPLE_US       1000000
+
+static struct task_stats before[TOP_MAX_TASKS];
+static struct task_stats after[TOP_MAX_TASKS];
+
+/* Find stats for pid in the first sample, NULL if it didn't exist yet */
+static struct task_stats *find_before(uint32_t pid, int count) {
+    for (int i = 0; i < count; i++) {
+        if (before[i].pid == pid) {
+            return &before[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Display memory usage, and CPU usage by task */
 void top(int argc, char **argv) {
+    int before_count, after_count;
+    uint64_t start_time, elapsed_us;
+#ifdef CONFIG_PERFCOUNTER
+    uint64_t start_count, elapsed_count;
+#endif
+
     printf("User free memory: %d bytes\r\n", mm_space());
     printf("Kernel free memory: %d bytes\r\n", mm_kspace());
+
+    start_time = system_time(0);
+#ifdef CONFIG_PERFCOUNTER
+    start_count = perfcounter_getcount();
+#endif
+    before_count = task_stats(before, TOP_MAX_TASKS);
+
+    usleep(SAMPLE_US);
+
+    after_count = task_stats(after, TOP_MAX_TASKS);
+#ifdef CONFIG_PERFCOUNTER
+    elapsed_count = perfcounter_getcount() - start_count;
+#endif
+    elapsed_us = system_time(start_time);
+
+    if (before_count < 0 || after_count < 0) {
+        printf("Unable to get task statistics\r\n");
+        return;
+    }
+
+    printf("\r\nPID\tPRI\tPERIOD\tCPU\tSW/S\tMAX LAT\tWCRT\tOVERRUN\tSTACK\r\n");
+
+    for (int i = 0; i < after_count; i++) {
+        struct task_stats *curr = &after[i];
+        struct task_stats *prev = find_before(curr->pid, before_count);
+        uint32_t switches = curr->switches;
+        uint32_t cpu = 0, latency = 0;
+
+        if (prev) {
+            switches -= prev->switches;
+        }
+
+#ifdef CONFIG_PERFCOUNTER
+        uint64_t runtime = curr->runtime;
+
+        if (prev) {
+            runtime -= prev->runtime;
+        }
+
+        if (elapsed_count) {
+            cpu = runtime * 100 / elapsed_count;
+        }
+
+        latency = curr->max_latency / (CONFIG_SYS_CLOCK / 1000000);
+#endif
+
+        printf("%u\t%u\t%u\t%u%%\t%u\t%uus\t%u\t%u\t%u/%u\r\n", curr->pid,
+               curr->priority, curr->period, cpu,
+               (uint32_t) (switches * 1000000ULL / elapsed_us), latency,
+               curr->max_response, curr->overruns, curr->stack_used,
+               curr->stack_size);
+    }
 }
 DEFINE_APP(top)
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <kernel/trace.h>
+#include "app.h"
+
+/* Events written per write to stdout */
+#define TRACE_CHUNK     16
+
+static const char *usage = "Usage:\r\n"                         \
+"trace start - clear trace and start recording\r\n"             \
+"trace stop - stop recording\r\n"                               \
+"trace dump - stop recording and write binary trace to stdout\r\n";
+
+static struct trace_event events[TRACE_CHUNK];
+
+/*
+ * Write the trace in the format described in kernel/trace.h, to be
+ * decoded on the host with tools/trace_decode.py.
+ */
+static void trace_dump(void) {
+    struct trace_header header = {
+        .version = TRACE_VERSION,
+        .event_size = sizeof(struct trace_event),
+        .timestamp_hz = CONFIG_SYS_CLOCK,
+    };
+    uint32_t index = 0;
+    int count;
+
+    trace_stop();
+
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.count = trace_count();
+
+    write_block(stdout, (char *) &header, sizeof(header));
+
+    while ((count = trace_read(events, index, TRACE_CHUNK)) > 0) {
+        write_block(stdout, (char *) events, count * sizeof(*events));
+        index += count;
+    }
+}
+
+void trace(int argc, char **argv) {
+    if (argc != 2) {
+        printf("%s", usage);
+        printf("%u events recorded\r\n", trace_count());
+        return;
+    }
+
+    if (!strncmp("start", argv[1], 6)) {
+        trace_start();
+    }
+    else if (!strncmp("stop", argv[1], 5)) {
+        trace_stop();
+    }
+    else if (!strncmp("dump", argv[1], 5)) {
+        trace_dump();
+    }
+    else {
+        printf("%s", usage);
+    }
+}
+DEFINE_APP(trace)
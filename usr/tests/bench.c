@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <dev/hw/perfcounter.h>
+#include <kernel/mutex.h>
+#include <kernel/sched.h>
+#include <kernel/semaphore.h>
+#include "test.h"
+
+/*
+ * Scheduler benchmarks
+ *
+ * Each benchmark runs in its own task, above the test runner, and collects
+ * BENCH_SAMPLES timings in system clock cycles.  The minimum, average,
+ * maximum, and 99th percentile are reported in the test message.
+ *
+ * Timings come from the perfcounter, as in the interrupt latency test.  The
+ * cost of reading the counter is measured first, and subtracted from every
+ * interval.  F4OS does not boot in QEMU's STM32F4 machines, so benchmarks
+ * must be run on a board; see docs/stm32f4.md.
+ */
+
+#define BENCH_SAMPLES       200
+#define BENCH_PRIORITY      5
+#define BENCH_TIMEOUT_US    5000000
+
+#define TICK_US             (1000000 / CONFIG_SYSTICK_FREQ)
+#define TICK_NS             (NSEC_PER_SEC / CONFIG_SYSTICK_FREQ)
+#define CYCLES_PER_US       (CONFIG_SYS_CLOCK / 1000000)
+
+static uint32_t bench_samples[BENCH_SAMPLES];
+static volatile int bench_count;
+static uint32_t bench_overhead;
+
+/* Posted by the benchmark once it has collected its samples */
+static struct semaphore bench_done = INIT_SEMAPHORE(bench_done, 0);
+
+static inline uint32_t bench_cycles(void) {
+    return (uint32_t) perfcounter_getcount();
+}
+
+/* Cycles since start, less the cost of reading the counter */
+static uint32_t bench_elapsed(uint32_t start) {
+    uint32_t cycles = bench_cycles() - start;
+
+    return cycles > bench_overhead ? cycles - bench_overhead : 0;
+}
+
+/* Cycles from the last system tick until now */
+static uint32_t bench_since_tick(void) {
+    uint32_t ns = clock_monotonic_ns() % TICK_NS;
+
+    return ns * CYCLES_PER_US / 1000;
+}
+
+static void bench_sample(uint32_t cycles) {
+    if (bench_count < BENCH_SAMPLES) {
+        bench_samples[bench_count++] = cycles;
+    }
+}
+
+static void bench_reset(void) {
+    bench_count = 0;
+    init_semaphore(&bench_done, 0);
+
+    /* Cheapest back to back read of the counter */
+    bench_overhead = UINT32_MAX;
+    for (int i = 0; i < 16; i++) {
+        uint32_t start = bench_cycles();
+        uint32_t cycles = bench_cycles() - start;
+
+        if (cycles < bench_overhead) {
+            bench_overhead = cycles;
+        }
+    }
+}
+
+/* Wait for the benchmark to finish, and report its samples */
+static int bench_report(char *message, int len) {
+    uint64_t total = 0;
+
+    if (sem_wait(&bench_done, BENCH_TIMEOUT_US)) {
+        scnprintf(message, len, "Timed out after %d samples", bench_count);
+        return FAILED;
+    }
+
+    /* Insertion sort, for the percentile */
+    for (int i = 1; i < bench_count; i++) {
+        uint32_t sample = bench_samples[i];
+        int j = i;
+
+        while (j > 0 && bench_samples[j-1] > sample) {
+            bench_samples[j] = bench_samples[j-1];
+            j--;
+        }
+
+        bench_samples[j] = sample;
+    }
+
+    for (int i = 0; i < bench_count; i++) {
+        total += bench_samples[i];
+    }
+
+    scnprintf(message, len, "cycles min %u avg %u max %u p99 %u",
+              bench_samples[0], (uint32_t) (total / bench_count),
+              bench_samples[bench_count - 1],
+              bench_samples[(bench_count * 99 + 99) / 100 - 1]);
+
+    return PASSED;
+}
+
+/* Run fn in a benchmark task, and report its samples */
+static int bench_run(void (*fn)(void), char *message, int len) {
+    bench_reset();
+
+    if (!new_task(fn, BENCH_PRIORITY, 0)) {
+        scnprintf(message, len, "Unable to create task");
+        return FAILED;
+    }
+
+    return bench_report(message, len);
+}
+
+/* Yield to self, through the service call and scheduler */
+static void yield_bench(void) {
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint32_t start = bench_cycles();
+        yield_if_possible();
+        bench_sample(bench_elapsed(start));
+    }
+
+    sem_post(&bench_done);
+}
+
+static int yield_test(char *message, int len) {
+    return bench_run(yield_bench, message, len);
+}
+DEFINE_TEST("Benchmark: yield round trip", yield_test);
+
+static struct mutex bench_mutex = INIT_MUTEX;
+
+/* Acquire and release of a free mutex */
+static void mutex_bench(void) {
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint32_t start = bench_cycles();
+        acquire(&bench_mutex);
+        release(&bench_mutex);
+        bench_sample(bench_elapsed(start));
+    }
+
+    sem_post(&bench_done);
+}
+
+static int mutex_test(char *message, int len) {
+    return bench_run(mutex_bench, message, len);
+}
+DEFINE_TEST("Benchmark: mutex acquire/release", mutex_test);
+
+static struct semaphore holder_go = INIT_SEMAPHORE(holder_go, 0);
+static struct semaphore holder_held = INIT_SEMAPHORE(holder_held, 0);
+
+/* Lower priority task, holding the mutex each time the benchmark acquires */
+static void mutex_holder(void) {
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        sem_wait(&holder_go, TIMEOUT_FOREVER);
+        acquire(&bench_mutex);
+
+        /* Preempted by the benchmark task, still holding the mutex */
+        sem_post(&holder_held);
+
+        release(&bench_mutex);
+    }
+}
+
+/* Acquire of a held mutex, until the holder hands it over */
+static void mutex_contended_bench(void) {
+    init_semaphore(&holder_go, 0);
+    init_semaphore(&holder_held, 0);
+
+    new_task(mutex_holder, BENCH_PRIORITY - 1, 0);
+
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint32_t start;
+
+        sem_post(&holder_go);
+        sem_wait(&holder_held, TIMEOUT_FOREVER);
+
+        start = bench_cycles();
+        acquire(&bench_mutex);
+        bench_sample(bench_elapsed(start));
+
+        release(&bench_mutex);
+    }
+
+    sem_post(&bench_done);
+}
+
+static int mutex_contended_test(char *message, int len) {
+    return bench_run(mutex_contended_bench, message, len);
+}
+DEFINE_TEST("Benchmark: contended mutex acquire", mutex_contended_test);
+
+static volatile int periodic_exited;
+
+/* Each job samples its start, relative to its release tick */
+static void periodic_job(void) {
+    if (bench_count == BENCH_SAMPLES) {
+        periodic_exited = 1;
+        abort();
+    }
+
+    bench_sample(bench_since_tick());
+
+    if (bench_count == BENCH_SAMPLES) {
+        sem_post(&bench_done);
+    }
+}
+
+static int periodic_test(char *message, int len) {
+    int ret;
+
+    bench_reset();
+    periodic_exited = 0;
+
+    if (!new_task(periodic_job, BENCH_PRIORITY, TICK_US)) {
+        scnprintf(message, len, "Unable to create task");
+        return FAILED;
+    }
+
+    ret = bench_report(message, len);
+
+    /* The job after the last sample ends the task */
+    while (ret == PASSED && !periodic_exited) {
+        usleep(TICK_US);
+    }
+
+    return ret;
+}
+DEFINE_TEST("Benchmark: periodic release jitter", periodic_test);
+
+/* Sleep for a tick at a time, and sample the wake, relative to the tick */
+static void tick_wake_bench(void) {
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        usleep(TICK_US);
+        bench_sample(bench_since_tick());
+    }
+
+    sem_post(&bench_done);
+}
+
+static int tick_wake_test(char *message, int len) {
+    return bench_run(tick_wake_bench, message, len);
+}
+DEFINE_TEST("Benchmark: system tick to task latency", tick_wake_test);
+
+static void empty_task(void) {}
+
+static void new_task_bench(void) {
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint32_t start = bench_cycles();
+        new_task(empty_task, BENCH_PRIORITY - 1, 0);
+        bench_sample(bench_elapsed(start));
+
+        /* Let the task run and end, so tasks don't accumulate */
+        usleep(TICK_US);
+    }
+
+    sem_post(&bench_done);
+}
+
+static int new_task_test(char *message, int len) {
+    return bench_run(new_task_bench, message, len);
+}
+DEFINE_TEST("Benchmark: task creation", new_task_test);
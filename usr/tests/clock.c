@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "test.h"
+
+#define CLOCK_READS     10000
+
+#define TICK_NS         (NSEC_PER_SEC / CONFIG_SYSTICK_FREQ)
+
+#define CLOCK_SLEEP_US  10000
+
+/*
+ * The clock must never go backwards, including across system ticks, and
+ * should resolve time within a system tick.
+ */
+static int clock_monotonic_test(char *message, int len) {
+    uint64_t prev = clock_monotonic_ns();
+    uint32_t start_ticks = system_ticks;
+    uint32_t sub_tick = 0;
+
+    for (int i = 0; i < CLOCK_READS; i++) {
+        uint64_t now = clock_monotonic_ns();
+
+        if (now < prev) {
+            scnprintf(message, len, "Clock went backwards by %u ns",
+                      (uint32_t) (prev - now));
+            return FAILED;
+        }
+
+        if (now != prev && now - prev < TICK_NS) {
+            sub_tick++;
+        }
+
+        prev = now;
+    }
+
+    if (system_ticks == start_ticks) {
+        scnprintf(message, len, "No system tick during test");
+        return FAILED;
+    }
+
+#ifdef CONFIG_ARCH_ARMV7M
+    if (!sub_tick) {
+        scnprintf(message, len, "Clock only advanced by whole ticks");
+        return FAILED;
+    }
+#endif
+
+    return PASSED;
+}
+DEFINE_TEST("Monotonic clock", clock_monotonic_test);
+
+/* clock_gettime() should agree with the scheduler's notion of time */
+static int clock_gettime_test(char *message, int len) {
+    struct timespec start, end;
+    uint64_t elapsed_ns;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &start)) {
+        scnprintf(message, len, "clock_gettime failed");
+        return FAILED;
+    }
+
+    usleep(CLOCK_SLEEP_US);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed_ns = (uint64_t) (end.tv_sec - start.tv_sec) * NSEC_PER_SEC
+                 + end.tv_nsec - start.tv_nsec;
+
+    /*
+     * Sleeps never end early, but wait out the partial tick they start
+     * in, and may then wake a tick late
+     */
+    if (elapsed_ns < CLOCK_SLEEP_US * 1000ULL ||
+            elapsed_ns > CLOCK_SLEEP_US * 1000ULL + 3 * TICK_NS) {
+        scnprintf(message, len, "Slept %u us, clock measured %u ns",
+                  CLOCK_SLEEP_US, (uint32_t) elapsed_ns);
+        return FAILED;
+    }
+
+    if (end.tv_nsec >= NSEC_PER_SEC) {
+        scnprintf(message, len, "tv_nsec out of range: %u", end.tv_nsec);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("clock_gettime", clock_gettime_test);
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <kernel/mutex.h>
+#include <kernel/sched.h>
+#include <kernel/workqueue.h>
+#include "test.h"
+
+#define EDF_TASKS           3
+
+/* Total utilization of the task set, in percent */
+#define UTILIZATION_PERCENT 90
+
+/* Window to count completed jobs over, in system ticks */
+#define WINDOW_TICKS        CONFIG_SYSTICK_FREQ
+
+/* Window to calibrate burn() over, in system ticks */
+#define CALIBRATE_TICKS     (CONFIG_SYSTICK_FREQ / 10)
+
+#define BURN_CHUNK          100
+
+struct edf_task {
+    uint32_t            period_us;
+    uint32_t            work;   /* burn() iterations per job */
+    volatile uint32_t   jobs;
+};
+
+/*
+ * Mixed, non-harmonic periods.  Under rate monotonic scheduling, three
+ * tasks are only guaranteed schedulable up to ~78% utilization.
+ */
+static struct edf_task edf_tasks[EDF_TASKS] = {
+    { .period_us = 4000 },
+    { .period_us = 6000 },
+    { .period_us = 10000 },
+};
+
+static volatile int edf_done;
+static atomic_t edf_running;
+
+static void burn(uint32_t iterations) {
+    for (volatile uint32_t i = 0; i < iterations; i++);
+}
+
+/* Periodic tasks are released once every period + 1 ticks */
+static uint32_t release_ticks(struct edf_task *task) {
+    return DIV_ROUND_UP(task->period_us * CONFIG_SYSTICK_FREQ, 1000000) + 1;
+}
+
+static void edf_job(struct edf_task *task) {
+    if (edf_done) {
+        atomic_dec(&edf_running);
+        abort();
+    }
+
+    burn(task->work);
+    task->jobs++;
+}
+
+static void edf_task0(void) {
+    edf_job(&edf_tasks[0]);
+}
+
+static void edf_task1(void) {
+    edf_job(&edf_tasks[1]);
+}
+
+static void edf_task2(void) {
+    edf_job(&edf_tasks[2]);
+}
+
+static void (* const edf_fptrs[EDF_TASKS])(void) = {
+    edf_task0,
+    edf_task1,
+    edf_task2,
+};
+
+/*
+ * Iterations of burn() we get per system tick.  Measured with the rest of
+ * the system running, so it already accounts for tick and kernel task
+ * overhead.
+ */
+static uint32_t calibrate(void) {
+    uint32_t start, count = 0;
+
+    /* Start on a tick edge */
+    start = system_ticks;
+    while (system_ticks == start);
+    start = system_ticks;
+
+    while (system_ticks - start < CALIBRATE_TICKS) {
+        burn(BURN_CHUNK);
+        count++;
+    }
+
+    return count * BURN_CHUNK / CALIBRATE_TICKS;
+}
+
+/*
+ * Run a periodic task set with UTILIZATION_PERCENT total utilization, split
+ * evenly between the tasks, and check that every released job completes
+ * before the task's next release.  A task still running at its release edge
+ * misses that release, and completes fewer jobs.
+ */
+static int edf_schedulability_test(char *message, int len) {
+    uint32_t per_tick = calibrate();
+    uint32_t start_jobs[EDF_TASKS];
+    int ret = PASSED;
+
+    edf_done = 0;
+    atomic_set(&edf_running, EDF_TASKS);
+
+    for (int i = 0; i < EDF_TASKS; i++) {
+        struct edf_task *task = &edf_tasks[i];
+
+        task->work = per_tick * release_ticks(task)
+                     * UTILIZATION_PERCENT / (100 * EDF_TASKS);
+        task->jobs = 0;
+
+        new_task(edf_fptrs[i], 1, task->period_us);
+    }
+
+    /* Let every task get through a few periods */
+    usleep(4 * edf_tasks[EDF_TASKS-1].period_us);
+
+    for (int i = 0; i < EDF_TASKS; i++) {
+        start_jobs[i] = edf_tasks[i].jobs;
+    }
+
+    usleep(WINDOW_TICKS * (1000000 / CONFIG_SYSTICK_FREQ));
+
+    for (int i = 0; i < EDF_TASKS; i++) {
+        struct edf_task *task = &edf_tasks[i];
+        uint32_t jobs = task->jobs - start_jobs[i];
+        uint32_t expected = WINDOW_TICKS / release_ticks(task);
+
+        /* Allow one job for misalignment with the window */
+        if (jobs + 1 < expected) {
+            scnprintf(message, len, "Task with period %u us completed "
+                      "%u of %u jobs", task->period_us, jobs, expected);
+            ret = FAILED;
+            break;
+        }
+    }
+
+    edf_done = 1;
+    while (atomic_read(&edf_running)) {
+        usleep(edf_tasks[EDF_TASKS-1].period_us);
+    }
+
+    return ret;
+}
+DEFINE_TEST("EDF schedulability", edf_schedulability_test);
+
+/* Hold time of the non-periodic owner, and runtime of the periodic hog */
+#define INVERSION_HOLD_US   2000
+#define INVERSION_SPIN_US   20000
+
+#define INVERSION_WAITER_PERIOD_US  5000
+#define INVERSION_HOG_PERIOD_US     (2 * INVERSION_SPIN_US)
+
+static struct mutex inversion_lock = INIT_MUTEX;
+static volatile uint32_t inversion_wait_us;
+static atomic_t inversion_tasks;
+
+static void spin_us(uint32_t us) {
+    uint64_t start = system_time(0);
+
+    while (system_time(start) < us);
+}
+
+/* Periodic, with an earlier deadline than the hog */
+static void inversion_waiter(void) {
+    uint64_t start = system_time(0);
+
+    acquire(&inversion_lock);
+    inversion_wait_us = system_time(start);
+    release(&inversion_lock);
+
+    atomic_dec(&inversion_tasks);
+    abort();
+}
+
+/* Periodic, with a later deadline than the waiter */
+static void inversion_hog(void) {
+    spin_us(INVERSION_SPIN_US);
+
+    atomic_dec(&inversion_tasks);
+    abort();
+}
+
+static void inversion_owner(void) {
+    acquire(&inversion_lock);
+
+    /* The waiter runs immediately, and blocks on the mutex */
+    new_task(&inversion_waiter, 1, INVERSION_WAITER_PERIOD_US);
+    new_task(&inversion_hog, 1, INVERSION_HOG_PERIOD_US);
+
+    spin_us(INVERSION_HOLD_US);
+
+    release(&inversion_lock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+/*
+ * A non-periodic task holds a mutex wanted by a periodic task, while
+ * another periodic task with a later deadline hogs the CPU.  Periodic tasks
+ * run ahead of all non-periodic tasks, so raising the owner's priority
+ * doesn't help.  The owner must inherit the waiter's deadline to run ahead
+ * of the hog, otherwise the waiter waits for the whole spin.
+ */
+static int edf_priority_inversion_test(char *message, int len) {
+    atomic_set(&inversion_tasks, 3);
+
+    new_task(&inversion_owner, 1, 0);
+
+    while (atomic_read(&inversion_tasks)) {
+        usleep(1000);
+    }
+
+    if (inversion_wait_us >= INVERSION_SPIN_US / 2) {
+        scnprintf(message, len, "Periodic task waited %u us",
+                  inversion_wait_us);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("EDF priority inversion", edf_priority_inversion_test);
+
+#define WORKER_HOG_PERIOD_US    (2 * INVERSION_SPIN_US)
+
+static volatile uint64_t worker_queued;
+static volatile uint32_t worker_wait_us;
+static atomic_t worker_tasks;
+
+static void worker_func(struct work *work) {
+    worker_wait_us = system_time(worker_queued);
+}
+
+static struct work worker_work = INIT_WORK(worker_func);
+
+/* Periodic, queues work and then hogs the CPU */
+static void worker_hog(void) {
+    worker_queued = system_time(0);
+    queue_work(&worker_work);
+
+    spin_us(INVERSION_SPIN_US);
+
+    atomic_dec(&worker_tasks);
+    abort();
+}
+
+/*
+ * A periodic task queues work, then hogs the CPU.  Periodic tasks run ahead
+ * of all non-periodic tasks, so the worker must have a deadline of its own
+ * to run the work promptly, rather than after the whole spin.
+ */
+static int edf_workqueue_test(char *message, int len) {
+    worker_wait_us = UINT32_MAX;
+    atomic_set(&worker_tasks, 1);
+
+    new_task(&worker_hog, 1, WORKER_HOG_PERIOD_US);
+
+    while (atomic_read(&worker_tasks)) {
+        usleep(1000);
+    }
+
+    /* Wait for the work, if it never preempted the hog */
+    usleep(1000);
+
+    if (worker_wait_us >= INVERSION_SPIN_US / 2) {
+        scnprintf(message, len, "Work waited %u us", worker_wait_us);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("EDF work queue latency", edf_workqueue_test);
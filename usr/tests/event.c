@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/event.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+#define EVENT_A         (1 << 0)
+#define EVENT_B         (1 << 1)
+#define EVENT_DONE      (1 << 31)
+
+#define EVENT_TIMEOUT_US    10000
+
+static struct event_group events = INIT_EVENT_GROUP(events);
+static volatile uint32_t event_received;
+
+static void event_waiter(void) {
+    uint32_t received;
+
+    event_wait(&events, EVENT_A | EVENT_B, EVENT_WAIT_ALL | EVENT_WAIT_CLEAR,
+               TIMEOUT_FOREVER, &received);
+
+    event_received = received;
+    event_set(&events, EVENT_DONE);
+}
+
+/* A wait-all waiter must only wake once every flag is set */
+static int event_wait_all_test(char *message, int len) {
+    init_event_group(&events);
+    event_received = 0;
+
+    new_task(&event_waiter, 1, 0);
+
+    event_set(&events, EVENT_A);
+    usleep(1000);
+
+    if (event_received) {
+        scnprintf(message, len, "Woken with only 0x%x set", event_received);
+        return FAILED;
+    }
+
+    event_set(&events, EVENT_B);
+
+    if (event_wait(&events, EVENT_DONE, EVENT_WAIT_ANY | EVENT_WAIT_CLEAR,
+                   100*EVENT_TIMEOUT_US, NULL)) {
+        scnprintf(message, len, "Waiter never woke");
+        return FAILED;
+    }
+
+    if ((event_received & (EVENT_A | EVENT_B)) != (EVENT_A | EVENT_B)) {
+        scnprintf(message, len, "Waiter received 0x%x", event_received);
+        return FAILED;
+    }
+
+    if (events.flags & (EVENT_A | EVENT_B)) {
+        scnprintf(message, len, "Flags 0x%x not cleared", events.flags);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Event wait all", event_wait_all_test);
+
+static int event_timeout_test(char *message, int len) {
+    init_event_group(&events);
+
+    event_set(&events, EVENT_A);
+
+    if (event_wait(&events, EVENT_A | EVENT_B, EVENT_WAIT_ANY, 0, NULL)) {
+        scnprintf(message, len, "Wait any not satisfied by one flag");
+        return FAILED;
+    }
+
+    if (!event_wait(&events, EVENT_A | EVENT_B, EVENT_WAIT_ALL,
+                    EVENT_TIMEOUT_US, NULL)) {
+        scnprintf(message, len, "Wait all satisfied by one flag");
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Event timeout", event_timeout_test);
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/hrtimer.h>
+#include <kernel/semaphore.h>
+#include "test.h"
+
+#define HRTIMER_TIMERS      3
+#define HRTIMER_SLEEPS      3
+
+/* Timers expire in interrupt context, so allow for its latency */
+#define HRTIMER_SLACK_NS    50000
+
+static struct semaphore hrtimer_sem = INIT_SEMAPHORE(hrtimer_sem, 0);
+static struct hrtimer timers[HRTIMER_TIMERS];
+static volatile int expired[HRTIMER_TIMERS];
+static volatile int expired_count;
+
+static void hrtimer_test_callback(struct hrtimer *timer) {
+    expired[expired_count++] = timer - timers;
+    sem_post(&hrtimer_sem);
+}
+
+static void hrtimer_test_reset(void) {
+    for (int i = 0; i < HRTIMER_TIMERS; i++) {
+        init_hrtimer(&timers[i], hrtimer_test_callback);
+        expired[i] = -1;
+    }
+
+    expired_count = 0;
+    init_semaphore(&hrtimer_sem, 0);
+}
+
+/* Timers must expire in order of expiration, not of starting */
+static int hrtimer_order_test(char *message, int len) {
+    /* Expiration order is 1, 2, 0 */
+    static const uint32_t delays_us[HRTIMER_TIMERS] = { 3000, 1000, 2000 };
+    static const int order[HRTIMER_TIMERS] = { 1, 2, 0 };
+
+    hrtimer_test_reset();
+
+    for (int i = 0; i < HRTIMER_TIMERS; i++) {
+        hrtimer_start(&timers[i], delays_us[i] * 1000);
+    }
+
+    for (int i = 0; i < HRTIMER_TIMERS; i++) {
+        if (sem_wait(&hrtimer_sem, 100000)) {
+            scnprintf(message, len, "Only %d of %d timers expired",
+                      expired_count, HRTIMER_TIMERS);
+            return FAILED;
+        }
+    }
+
+    for (int i = 0; i < HRTIMER_TIMERS; i++) {
+        if (expired[i] != order[i]) {
+            scnprintf(message, len, "Expiration %d was timer %d, expected %d",
+                      i, expired[i], order[i]);
+            return FAILED;
+        }
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("High resolution timer order", hrtimer_order_test);
+
+/* Sleeps should be accurate well within a system tick */
+static int hrtimer_usleep_test(char *message, int len) {
+    static const uint32_t sleeps_us[HRTIMER_SLEEPS] = { 100, 1250, 9040 };
+
+    for (int i = 0; i < HRTIMER_SLEEPS; i++) {
+        uint64_t start, elapsed;
+
+        start = clock_monotonic_ns();
+        hrtimer_usleep(sleeps_us[i]);
+        elapsed = clock_monotonic_ns() - start;
+
+        if (elapsed < sleeps_us[i] * 1000ULL ||
+                elapsed > sleeps_us[i] * 1000ULL + HRTIMER_SLACK_NS) {
+            scnprintf(message, len, "Slept %u us, clock measured %u ns",
+                      sleeps_us[i], (uint32_t) elapsed);
+            return FAILED;
+        }
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("High resolution sleep", hrtimer_usleep_test);
+
+/* Cancelled timers must not expire */
+static int hrtimer_cancel_test(char *message, int len) {
+    hrtimer_test_reset();
+
+    hrtimer_start(&timers[0], 2000000);
+    hrtimer_start(&timers[1], 1000000);
+
+    if (hrtimer_cancel(&timers[0]) != 1) {
+        scnprintf(message, len, "Pending timer not cancelled");
+        return FAILED;
+    }
+
+    if (sem_wait(&hrtimer_sem, 100000)) {
+        scnprintf(message, len, "Remaining timer did not expire");
+        return FAILED;
+    }
+
+    /* Past the cancelled expiration */
+    hrtimer_usleep(2000);
+
+    if (expired_count != 1 || expired[0] != 1) {
+        scnprintf(message, len, "%d timers expired, first %d",
+                  expired_count, expired[0]);
+        return FAILED;
+    }
+
+    if (hrtimer_cancel(&timers[0]) != 0) {
+        scnprintf(message, len, "Cancelled timer still pending");
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("High resolution timer cancel", hrtimer_cancel_test);
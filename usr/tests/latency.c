@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <dev/hw/perfcounter.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+/*
+ * Interrupt latency benchmark
+ *
+ * A high priority task sleeps for one system tick at a time, so each wake
+ * comes from the system tick interrupt.  The scheduler records how long the
+ * task was ready before it ran, and the task records the spacing of its
+ * wakes.  Both are reported in the test message, which the test runner
+ * prints whether the test passes or fails.
+ */
+
+#define LATENCY_WAKES       200
+#define TICK_CYCLES         (CONFIG_SYS_CLOCK / CONFIG_SYSTICK_FREQ)
+
+static volatile int latency_done;
+static uint32_t jitter_max, jitter_total, max_latency;
+static struct task_stats stats[32];
+
+static void latency_task(void) {
+    uint64_t last, now;
+
+    usleep(1000000 / CONFIG_SYSTICK_FREQ);
+    last = perfcounter_getcount();
+
+    for (int i = 0; i < LATENCY_WAKES; i++) {
+        usleep(1000000 / CONFIG_SYSTICK_FREQ);
+        now = perfcounter_getcount();
+
+        /* Wakes may be one or more ticks apart, so use the offset from one */
+        uint32_t jitter = (uint32_t) (now - last) % TICK_CYCLES;
+        if (jitter > TICK_CYCLES / 2) {
+            jitter = TICK_CYCLES - jitter;
+        }
+
+        jitter_total += jitter;
+        if (jitter > jitter_max) {
+            jitter_max = jitter;
+        }
+
+        last = now;
+    }
+
+    /* Collect our own statistics, before this task ends */
+    int count = task_stats(stats, 32);
+    for (int i = 0; i < count; i++) {
+        if (stats[i].fptr == latency_task) {
+            max_latency = stats[i].max_latency;
+        }
+    }
+
+    latency_done = 1;
+}
+
+static int latency_test(char *message, int len) {
+    latency_done = 0;
+    jitter_max = jitter_total = max_latency = 0;
+
+    new_task(&latency_task, 5, 0);
+
+    for (int i = 0; i < 1000 && !latency_done; i++) {
+        usleep(1000);
+    }
+
+    if (!latency_done) {
+        scnprintf(message, len, "Timed out");
+        return FAILED;
+    }
+
+    scnprintf(message, len, "wake latency max %fus, jitter avg %fus max %fus",
+              max_latency / (CONFIG_SYS_CLOCK / 1e6),
+              (jitter_total / (float) LATENCY_WAKES) / (CONFIG_SYS_CLOCK / 1e6),
+              jitter_max / (CONFIG_SYS_CLOCK / 1e6));
+
+    /* The highest priority ready task must run before the next tick */
+    if (max_latency >= TICK_CYCLES) {
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Interrupt latency", latency_test);
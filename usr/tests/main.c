@@ -48,18 +48,18 @@ void run_tests(void) {
 
         if (ret) {
             failures++;
-
             printf("FAILED");
+        }
+        else {
+            printf("PASSED");
+        }
 
-            if (message[0]) {
-                printf(" - '%s'\r\n", message);
-            }
-            else {
-                printf("\r\n");
-            }
+        /* Failures explain themselves, and benchmarks report results */
+        if (message[0]) {
+            printf(" - '%s'\r\n", message);
         }
         else {
-            printf("PASSED\r\n");
+            printf("\r\n");
         }
     }
 
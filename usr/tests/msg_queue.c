@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/msg_queue.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+#define QUEUE_DEPTH     4
+#define QUEUE_MESSAGES  32
+#define QUEUE_TIMEOUT   10000
+
+struct sample {
+    uint32_t    sequence;
+    uint32_t    value;
+};
+
+DEFINE_MSG_QUEUE(sample_queue, sizeof(struct sample), QUEUE_DEPTH);
+
+static void sample_producer(void) {
+    for (uint32_t i = 0; i < QUEUE_MESSAGES; i++) {
+        struct sample sample = {
+            .sequence = i,
+            .value = ~i,
+        };
+
+        msg_queue_send(&sample_queue, &sample, TIMEOUT_FOREVER);
+    }
+}
+
+/*
+ * A producer sending more messages than fit in the queue blocks when it is
+ * full.  Every message must still arrive, in order.
+ */
+static int msg_queue_order_test(char *message, int len) {
+    new_task(&sample_producer, 1, 0);
+
+    for (uint32_t i = 0; i < QUEUE_MESSAGES; i++) {
+        struct sample sample;
+
+        if (msg_queue_receive(&sample_queue, &sample, 100*QUEUE_TIMEOUT)) {
+            scnprintf(message, len, "Timed out waiting for message %u", i);
+            return FAILED;
+        }
+
+        if (sample.sequence != i || sample.value != ~i) {
+            scnprintf(message, len, "Message %u received as %u (0x%x)", i,
+                      sample.sequence, sample.value);
+            return FAILED;
+        }
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Message queue order", msg_queue_order_test);
+
+static int msg_queue_timeout_test(char *message, int len) {
+    uint32_t buffer[1];
+    struct msg_queue queue;
+    uint64_t start, elapsed;
+    uint32_t msg = 0;
+
+    init_msg_queue(&queue, buffer, sizeof(msg), 1);
+
+    start = system_time(0);
+
+    if (!msg_queue_receive(&queue, &msg, QUEUE_TIMEOUT)) {
+        scnprintf(message, len, "Received from empty queue");
+        return FAILED;
+    }
+
+    elapsed = system_time(start);
+
+    if (elapsed < QUEUE_TIMEOUT) {
+        scnprintf(message, len, "Timed out after only %u us",
+                  (uint32_t) elapsed);
+        return FAILED;
+    }
+
+    if (msg_queue_post(&queue, &msg)) {
+        scnprintf(message, len, "Post to empty queue failed");
+        return FAILED;
+    }
+
+    if (!msg_queue_send(&queue, &msg, QUEUE_TIMEOUT)) {
+        scnprintf(message, len, "Sent to full queue");
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Message queue timeout", msg_queue_timeout_test);
+
+static int msg_queue_zero_copy_test(char *message, int len) {
+    void *buffer[1];
+    struct msg_queue queue;
+    static struct sample sample;
+    void *received = NULL;
+
+    init_msg_queue(&queue, buffer, sizeof(void *), 1);
+
+    msg_queue_send_ptr(&queue, &sample, 0);
+
+    if (msg_queue_receive_ptr(&queue, &received, 0)
+            || received != &sample) {
+        scnprintf(message, len, "Received buffer 0x%x, expected 0x%x",
+                  received, &sample);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Message queue zero-copy", msg_queue_zero_copy_test);
+
+/* Zero-copy calls on a queue of larger messages must not touch the queue */
+static int msg_queue_zero_copy_size_test(char *message, int len) {
+    struct sample buffer[1];
+    struct msg_queue queue;
+    static struct sample sample;
+    void *received = NULL;
+
+    init_msg_queue(&queue, buffer, sizeof(struct sample), 1);
+
+    if (!msg_queue_send_ptr(&queue, &sample, 0)
+            || !msg_queue_post_ptr(&queue, &sample)) {
+        scnprintf(message, len, "Sent pointer to queue of %u byte messages",
+                  sizeof(struct sample));
+        return FAILED;
+    }
+
+    if (queue.count) {
+        scnprintf(message, len, "Failed send queued %u messages",
+                  queue.count);
+        return FAILED;
+    }
+
+    /* Fill the queue, so a receive would otherwise succeed */
+    msg_queue_send(&queue, &sample, 0);
+
+    if (!msg_queue_receive_ptr(&queue, &received, 0) || received) {
+        scnprintf(message, len, "Received pointer from queue of %u byte "
+                  "messages", sizeof(struct sample));
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Message queue zero-copy size", msg_queue_zero_copy_size_test);
@@ -20,9 +20,12 @@
  * SOFTWARE.
  */
 
+#include <atomic.h>
 #include <stdio.h>
 #include <time.h>
+#include <kernel/mutex.h>
 #include <kernel/reentrant_mutex.h>
+#include <kernel/sched.h>
 #include "test.h"
 
 int reentrant_mutex_basic_test(char *message, int len) {
@@ -67,3 +70,267 @@ int reentrant_mutex_task_test(char *message, int len) {
     return PASSED;
 }
 DEFINE_TEST("Reentrant mutex task", reentrant_mutex_task_test);
+
+#define HANDOFF_WAITERS 3
+
+static struct mutex handoff_lock = INIT_MUTEX;
+static volatile int handoff_next_id;
+static int handoff_order[HANDOFF_WAITERS];
+static atomic_t handoff_count;
+
+static void handoff_waiter(void) {
+    int id = handoff_next_id;
+
+    acquire(&handoff_lock);
+    handoff_order[atomic_inc(&handoff_count) - 1] = id;
+    release(&handoff_lock);
+}
+
+/*
+ * Waiters of increasing priority block on a held mutex.  On release, the
+ * mutex must be handed to them highest priority first.
+ */
+static int mutex_handoff_order_test(char *message, int len) {
+    atomic_set(&handoff_count, 0);
+
+    acquire(&handoff_lock);
+
+    for (int i = 0; i < HANDOFF_WAITERS; i++) {
+        handoff_next_id = i;
+        new_task(&handoff_waiter, 2 + i, 0);
+
+        /* Let the waiter run and block on the mutex */
+        usleep(1000);
+    }
+
+    release(&handoff_lock);
+
+    while (atomic_read(&handoff_count) < HANDOFF_WAITERS) {
+        usleep(1000);
+    }
+
+    for (int i = 0; i < HANDOFF_WAITERS; i++) {
+        int expected = HANDOFF_WAITERS - 1 - i;
+
+        if (handoff_order[i] != expected) {
+            scnprintf(message, len, "Handoff %d went to waiter %d, "
+                      "expected %d", i, handoff_order[i], expected);
+            return FAILED;
+        }
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Mutex handoff order", mutex_handoff_order_test);
+
+/* Hold time of the low priority task, and runtime of the medium priority task */
+#define INVERSION_HOLD_US   5000
+#define INVERSION_SPIN_US   50000
+
+static struct mutex inversion_lock = INIT_MUTEX;
+static volatile uint32_t inversion_wait_us;
+static atomic_t inversion_tasks;
+
+static void spin_us(uint32_t us) {
+    uint64_t start = system_time(0);
+
+    while (system_time(start) < us);
+}
+
+static void inversion_high(void) {
+    uint64_t start = system_time(0);
+
+    acquire(&inversion_lock);
+    inversion_wait_us = system_time(start);
+    release(&inversion_lock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+static void inversion_medium(void) {
+    spin_us(INVERSION_SPIN_US);
+
+    atomic_dec(&inversion_tasks);
+}
+
+static void inversion_low(void) {
+    acquire(&inversion_lock);
+
+    new_task(&inversion_high, 4, 0);
+    new_task(&inversion_medium, 3, 0);
+
+    spin_us(INVERSION_HOLD_US);
+
+    release(&inversion_lock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+/*
+ * A low priority task holds a mutex wanted by a high priority task, while a
+ * medium priority task hogs the CPU.  Without priority inheritance, the
+ * medium priority task preempts the holder, and the high priority task
+ * waits for the whole spin.  With it, the holder runs at high priority
+ * until it releases the mutex.
+ */
+static int mutex_priority_inversion_test(char *message, int len) {
+    atomic_set(&inversion_tasks, 3);
+
+    new_task(&inversion_low, 2, 0);
+
+    while (atomic_read(&inversion_tasks)) {
+        usleep(1000);
+    }
+
+    if (inversion_wait_us >= INVERSION_SPIN_US / 2) {
+        scnprintf(message, len, "High priority task waited %u us",
+                  inversion_wait_us);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Mutex priority inversion", mutex_priority_inversion_test);
+
+static struct mutex bookkeeping_lock = INIT_MUTEX;
+
+static void bookkeeping_high(void) {
+    uint64_t start = system_time(0);
+
+    acquire(&bookkeeping_lock);
+    inversion_wait_us = system_time(start);
+    release(&bookkeeping_lock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+static void bookkeeping_low(void) {
+    /*
+     * Take the mutex as the acquire() fast path does, but stop before
+     * recording it as held, as if preempted between the two.
+     */
+    bookkeeping_lock.lock = (uint32_t) curr_task;
+
+    new_task(&bookkeeping_high, 4, 0);
+    new_task(&inversion_medium, 3, 0);
+
+    spin_us(INVERSION_HOLD_US);
+
+    release(&bookkeeping_lock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+/*
+ * As the priority inversion test, but the holder is contended before it
+ * has recorded the mutex as held.  The kernel must still find the mutex,
+ * and boost the holder.
+ */
+static int mutex_fast_path_inversion_test(char *message, int len) {
+    atomic_set(&inversion_tasks, 3);
+
+    new_task(&bookkeeping_low, 2, 0);
+
+    while (atomic_read(&inversion_tasks)) {
+        usleep(1000);
+    }
+
+    if (inversion_wait_us >= INVERSION_SPIN_US / 2) {
+        scnprintf(message, len, "High priority task waited %u us",
+                  inversion_wait_us);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Mutex fast path priority inversion", mutex_fast_path_inversion_test);
+
+/* Mutex the stale task released, and mutex it really holds */
+static struct mutex stale_lock = INIT_MUTEX;
+static struct mutex stale_guard = INIT_MUTEX;
+static volatile int stale_done;
+static atomic_t stale_tasks;
+
+static void stale_wait(void) {
+    while (!stale_done) {
+        usleep(1000);
+    }
+}
+
+static void stale_holder(void) {
+    acquire(&stale_lock);
+
+    /*
+     * Drop the mutex as the release() fast path does, but stop before
+     * removing it from the held list, as if preempted between the two.
+     */
+    stale_lock.lock = 0;
+
+    acquire(&stale_guard);
+    stale_wait();
+    release(&stale_guard);
+
+    atomic_dec(&stale_tasks);
+}
+
+static void stale_contender(void) {
+    acquire(&stale_lock);
+    release(&stale_lock);
+
+    atomic_dec(&stale_tasks);
+}
+
+static void stale_owner(void) {
+    acquire(&stale_lock);
+
+    new_task(&stale_contender, 5, 0);
+    stale_wait();
+
+    release(&stale_lock);
+
+    atomic_dec(&stale_tasks);
+}
+
+static void stale_guard_waiter(void) {
+    acquire(&stale_guard);
+    release(&stale_guard);
+
+    atomic_dec(&stale_tasks);
+}
+
+/*
+ * A task still lists a mutex it has released, which another task now
+ * holds with a high priority waiter.  When a waiter blocks on a mutex the
+ * first task really holds, it must only inherit from that waiter.
+ */
+static int mutex_stale_held_test(char *message, int len) {
+    task_t *holder;
+    uint8_t priority;
+
+    stale_done = 0;
+    atomic_set(&stale_tasks, 4);
+
+    holder = new_task(&stale_holder, 2, 0);
+    usleep(1000);
+
+    new_task(&stale_owner, 3, 0);
+    usleep(1000);
+
+    new_task(&stale_guard_waiter, 4, 0);
+    usleep(1000);
+
+    priority = task_priority(holder);
+
+    stale_done = 1;
+    while (atomic_read(&stale_tasks)) {
+        usleep(1000);
+    }
+
+    if (priority != 4) {
+        scnprintf(message, len, "Holder priority %u, expected 4", priority);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Mutex stale held entry", mutex_stale_held_test);
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+#define OVERRUN_PERIOD_US       1000
+
+/* Ticks the first job runs for, overrunning several releases */
+#define OVERRUN_JOB_TICKS       (CONFIG_SYSTICK_FREQ / 200)
+
+#define OVERRUN_MAX_TASKS       32
+
+static volatile uint32_t overrun_jobs;
+static volatile uint32_t overrun_handled;
+static volatile int overrun_done;
+static volatile int overrun_exited;
+
+static struct task_stats overrun_stats[OVERRUN_MAX_TASKS];
+
+static void overrun_handler(task_t *task) {
+    overrun_handled++;
+}
+
+static void overrun_task(void) {
+    uint32_t start = system_ticks;
+
+    if (overrun_done) {
+        overrun_exited = 1;
+        abort();
+    }
+
+    /* Only the first job overruns */
+    if (overrun_jobs++ == 0) {
+        while (system_ticks - start < OVERRUN_JOB_TICKS);
+    }
+}
+
+/*
+ * Run a periodic task whose first job takes several periods, and check
+ * that the skipped releases are counted and reported, and that its worst
+ * case response time covers the long job.
+ */
+static int overrun_test(char *message, int len) {
+    struct task_stats *stats = NULL;
+    int count, ret = PASSED;
+
+    overrun_jobs = 0;
+    overrun_handled = 0;
+    overrun_done = 0;
+    overrun_exited = 0;
+
+    set_overrun_handler(overrun_handler);
+
+    if (!new_task(overrun_task, 2, OVERRUN_PERIOD_US)) {
+        scnprintf(message, len, "Unable to create task");
+        set_overrun_handler(NULL);
+        return FAILED;
+    }
+
+    /* Long enough for the long job, and a few normal jobs after it */
+    usleep(4 * OVERRUN_JOB_TICKS * (1000000 / CONFIG_SYSTICK_FREQ));
+
+    count = task_stats(overrun_stats, OVERRUN_MAX_TASKS);
+    for (int i = 0; i < count; i++) {
+        if (overrun_stats[i].fptr == overrun_task) {
+            stats = &overrun_stats[i];
+            break;
+        }
+    }
+
+    if (!stats) {
+        scnprintf(message, len, "Task not found in statistics");
+        ret = FAILED;
+    }
+    else if (stats->overruns < 2) {
+        scnprintf(message, len, "Expected at least 2 overruns, got %u",
+                  stats->overruns);
+        ret = FAILED;
+    }
+    else if (overrun_handled < stats->overruns) {
+        scnprintf(message, len, "Handler called %u times for %u overruns",
+                  overrun_handled, stats->overruns);
+        ret = FAILED;
+    }
+    else if (stats->max_response < OVERRUN_JOB_TICKS) {
+        scnprintf(message, len, "Worst response %u ticks, shorter than "
+                  "%u tick job", stats->max_response, OVERRUN_JOB_TICKS);
+        ret = FAILED;
+    }
+    else if (overrun_jobs < 2) {
+        scnprintf(message, len, "Task stopped running after overrun");
+        ret = FAILED;
+    }
+
+    overrun_done = 1;
+    while (!overrun_exited) {
+        usleep(OVERRUN_PERIOD_US);
+    }
+
+    set_overrun_handler(NULL);
+
+    return ret;
+}
+DEFINE_TEST("Periodic task overrun", overrun_test);
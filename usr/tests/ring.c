@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <ring.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+#define RING_SIZE       16
+#define STREAM_BYTES    4096
+#define STREAM_CHUNK    7
+
+DEFINE_RING(wrap_ring, RING_SIZE);
+DEFINE_RING(stream_ring, RING_SIZE);
+
+static int ring_wraparound_test(char *message, int len) {
+    uint8_t in[RING_SIZE+4], out[RING_SIZE+4];
+    uint8_t *region;
+    uint8_t next = 0;
+
+    for (int i = 0; i < sizeof(in); i++) {
+        in[i] = i;
+    }
+
+    if (ring_write(&wrap_ring, in, sizeof(in)) != RING_SIZE
+            || !ring_full(&wrap_ring)) {
+        scnprintf(message, len, "Ring of %d did not fill", RING_SIZE);
+        return FAILED;
+    }
+
+    if (ring_read(&wrap_ring, out, sizeof(out)) != RING_SIZE
+            || !ring_empty(&wrap_ring)) {
+        scnprintf(message, len, "Ring of %d did not drain", RING_SIZE);
+        return FAILED;
+    }
+
+    /* Odd-sized transfers cross the end of the buffer at every offset */
+    for (int i = 0; i < 4*RING_SIZE; i++) {
+        int num = (i % 5) + 1;
+
+        for (int j = 0; j < num; j++) {
+            in[j] = next + j;
+        }
+
+        if (ring_write(&wrap_ring, in, num) != num
+                || ring_read(&wrap_ring, out, num) != num) {
+            scnprintf(message, len, "Short transfer at pass %d", i);
+            return FAILED;
+        }
+
+        for (int j = 0; j < num; j++) {
+            if (out[j] != (uint8_t) (next + j)) {
+                scnprintf(message, len, "Pass %d byte %d: got %d, expected %d",
+                          i, j, out[j], (uint8_t) (next + j));
+                return FAILED;
+            }
+        }
+
+        next += num;
+    }
+
+    /* Zero-copy reads stop at the end of the buffer, then resume at the start */
+    ring_write(&wrap_ring, in, RING_SIZE);
+
+    size_t first = ring_read_peek(&wrap_ring, &region);
+    if (region + first != &wrap_ring.buf[RING_SIZE]) {
+        scnprintf(message, len, "Peeked region does not end with the buffer");
+        return FAILED;
+    }
+
+    ring_read_commit(&wrap_ring, first);
+
+    size_t second = ring_read_peek(&wrap_ring, &region);
+    if (region != wrap_ring.buf || first + second != RING_SIZE) {
+        scnprintf(message, len, "Peeked %u then %u of %d bytes", first, second,
+                  RING_SIZE);
+        return FAILED;
+    }
+
+    ring_discard(&wrap_ring);
+
+    if (!ring_empty(&wrap_ring)) {
+        scnprintf(message, len, "Ring not empty after discard");
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Ring wraparound", ring_wraparound_test);
+
+static void ring_producer(void) {
+    uint8_t chunk[STREAM_CHUNK];
+    uint32_t sent = 0;
+
+    while (sent < STREAM_BYTES) {
+        int num = STREAM_CHUNK;
+
+        if (num > STREAM_BYTES - sent) {
+            num = STREAM_BYTES - sent;
+        }
+
+        for (int i = 0; i < num; i++) {
+            chunk[i] = sent + i;
+        }
+
+        /* Retry what did not fit once the consumer makes room */
+        int written = ring_write(&stream_ring, chunk, num);
+        if (!written) {
+            usleep(1000);
+        }
+
+        sent += written;
+    }
+}
+
+/*
+ * A producer task and the test task share the ring with no locking.  Every
+ * byte must arrive exactly once, in order.
+ */
+static int ring_stream_test(char *message, int len) {
+    uint32_t received = 0;
+    int idle = 0;
+
+    new_task(&ring_producer, 1, 0);
+
+    while (received < STREAM_BYTES) {
+        uint8_t buf[RING_SIZE];
+        int num = ring_read(&stream_ring, buf, sizeof(buf));
+
+        if (!num) {
+            if (idle++ > 1000) {
+                scnprintf(message, len, "Timed out after %u bytes", received);
+                return FAILED;
+            }
+
+            usleep(1000);
+            continue;
+        }
+
+        idle = 0;
+
+        for (int i = 0; i < num; i++) {
+            if (buf[i] != (uint8_t) (received + i)) {
+                scnprintf(message, len, "Byte %u: got %d, expected %d",
+                          received + i, buf[i], (uint8_t) (received + i));
+                return FAILED;
+            }
+        }
+
+        received += num;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Ring producer/consumer", ring_stream_test);
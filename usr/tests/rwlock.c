@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <atomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/rwlock.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+#define RWLOCK_READERS      3
+#define RWLOCK_HOLD_US      2000
+
+static struct rwlock rwlock = INIT_RWLOCK(rwlock);
+static atomic_t active, max_active, finished;
+
+static void reader(void) {
+    read_acquire(&rwlock);
+
+    atomic_inc(&active);
+    if (atomic_read(&active) > atomic_read(&max_active)) {
+        atomic_set(&max_active, atomic_read(&active));
+    }
+
+    usleep(RWLOCK_HOLD_US);
+
+    atomic_dec(&active);
+    read_release(&rwlock);
+
+    atomic_inc(&finished);
+}
+
+/* Readers hold the lock at the same time, but never with a writer */
+static int rwlock_shared_test(char *message, int len) {
+    atomic_set(&active, 0);
+    atomic_set(&max_active, 0);
+    atomic_set(&finished, 0);
+
+    for (int i = 0; i < RWLOCK_READERS; i++) {
+        new_task(&reader, 2, 0);
+    }
+
+    /* Let every reader take the lock */
+    usleep(RWLOCK_HOLD_US / 2);
+
+    /* Blocks until all readers release */
+    write_acquire(&rwlock);
+
+    if (atomic_read(&active)) {
+        scnprintf(message, len, "Writer acquired with %d readers",
+                  atomic_read(&active));
+        write_release(&rwlock);
+        return FAILED;
+    }
+
+    write_release(&rwlock);
+
+    for (int i = 0; i < 100 && atomic_read(&finished) < RWLOCK_READERS; i++) {
+        usleep(1000);
+    }
+
+    if (atomic_read(&max_active) != RWLOCK_READERS) {
+        scnprintf(message, len, "At most %d of %d readers held the lock",
+                  atomic_read(&max_active), RWLOCK_READERS);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("rwlock shared readers", rwlock_shared_test);
+
+static char order[3];
+static atomic_t order_count;
+
+static void ordered_writer(void) {
+    write_acquire(&rwlock);
+    order[atomic_inc(&order_count) - 1] = 'W';
+    write_release(&rwlock);
+}
+
+static void ordered_reader(void) {
+    read_acquire(&rwlock);
+    order[atomic_inc(&order_count) - 1] = 'R';
+    read_release(&rwlock);
+}
+
+/* A reader arriving after a waiting writer must wait behind it */
+static int rwlock_writer_preference_test(char *message, int len) {
+    atomic_set(&order_count, 0);
+    order[0] = order[1] = order[2] = '\0';
+
+    read_acquire(&rwlock);
+
+    /* Writer blocks on our read lock, then the reader blocks behind it */
+    new_task(&ordered_writer, 3, 0);
+    usleep(1000);
+    new_task(&ordered_reader, 2, 0);
+    usleep(1000);
+
+    if (atomic_read(&order_count)) {
+        scnprintf(message, len, "'%c' ran while lock was held", order[0]);
+        read_release(&rwlock);
+        return FAILED;
+    }
+
+    read_release(&rwlock);
+
+    for (int i = 0; i < 100 && atomic_read(&order_count) < 2; i++) {
+        usleep(1000);
+    }
+
+    if (order[0] != 'W' || order[1] != 'R') {
+        scnprintf(message, len, "Expected order WR, got %s", order);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("rwlock writer preference", rwlock_writer_preference_test);
+
+/* Hold time of the low priority reader, and runtime of the medium priority task */
+#define INVERSION_HOLD_US   5000
+#define INVERSION_SPIN_US   50000
+
+static volatile uint32_t inversion_wait_us;
+static atomic_t inversion_tasks;
+
+static void spin_us(uint32_t us) {
+    uint64_t start = system_time(0);
+
+    while (system_time(start) < us);
+}
+
+static void inversion_writer(void) {
+    uint64_t start = system_time(0);
+
+    write_acquire(&rwlock);
+    inversion_wait_us = system_time(start);
+    write_release(&rwlock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+static void inversion_medium(void) {
+    spin_us(INVERSION_SPIN_US);
+
+    atomic_dec(&inversion_tasks);
+}
+
+static void inversion_reader(void) {
+    read_acquire(&rwlock);
+
+    new_task(&inversion_writer, 4, 0);
+    new_task(&inversion_medium, 3, 0);
+
+    spin_us(INVERSION_HOLD_US);
+
+    read_release(&rwlock);
+
+    atomic_dec(&inversion_tasks);
+}
+
+/*
+ * A low priority reader holds the lock wanted by a high priority writer,
+ * while a medium priority task hogs the CPU.  The reader must inherit the
+ * writer's priority until it releases, otherwise the writer waits for the
+ * whole spin.
+ */
+static int rwlock_priority_inversion_test(char *message, int len) {
+    atomic_set(&inversion_tasks, 3);
+
+    new_task(&inversion_reader, 2, 0);
+
+    while (atomic_read(&inversion_tasks)) {
+        usleep(1000);
+    }
+
+    if (inversion_wait_us >= INVERSION_SPIN_US / 2) {
+        scnprintf(message, len, "Writer waited %u us", inversion_wait_us);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("rwlock priority inversion", rwlock_priority_inversion_test);
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/sched.h>
+#include <kernel/semaphore.h>
+#include "test.h"
+
+#define SEM_ITEMS       16
+#define SEM_TIMEOUT_US  10000
+
+static struct semaphore items = INIT_SEMAPHORE(items, 0);
+static atomic_t consumed;
+
+static void consumer(void) {
+    for (int i = 0; i < SEM_ITEMS; i++) {
+        sem_wait(&items, TIMEOUT_FOREVER);
+        atomic_inc(&consumed);
+    }
+}
+
+/* A blocked consumer must receive every post */
+static int semaphore_producer_consumer_test(char *message, int len) {
+    atomic_set(&consumed, 0);
+
+    new_task(&consumer, 1, 0);
+
+    for (int i = 0; i < SEM_ITEMS; i++) {
+        sem_post(&items);
+
+        /* Give the consumer a chance to block again */
+        if (i % 2) {
+            usleep(1000);
+        }
+    }
+
+    for (int i = 0; i < 100 && atomic_read(&consumed) < SEM_ITEMS; i++) {
+        usleep(1000);
+    }
+
+    if (atomic_read(&consumed) != SEM_ITEMS) {
+        scnprintf(message, len, "Consumed %d of %d items",
+                  atomic_read(&consumed), SEM_ITEMS);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Semaphore producer/consumer", semaphore_producer_consumer_test);
+
+static int semaphore_timeout_test(char *message, int len) {
+    struct semaphore sem;
+    uint64_t start, elapsed;
+
+    init_semaphore(&sem, 1);
+
+    if (sem_wait(&sem, 0)) {
+        scnprintf(message, len, "Available count not taken");
+        return FAILED;
+    }
+
+    if (!sem_wait(&sem, 0)) {
+        scnprintf(message, len, "Empty semaphore taken without blocking");
+        return FAILED;
+    }
+
+    start = system_time(0);
+
+    if (!sem_wait(&sem, SEM_TIMEOUT_US)) {
+        scnprintf(message, len, "Empty semaphore taken after blocking");
+        return FAILED;
+    }
+
+    elapsed = system_time(start);
+
+    if (elapsed < SEM_TIMEOUT_US) {
+        scnprintf(message, len, "Timed out after only %u us",
+                  (uint32_t) elapsed);
+        return FAILED;
+    }
+
+    /* A timed out waiter must not consume a later post */
+    sem_post(&sem);
+
+    if (sem_wait(&sem, 0)) {
+        scnprintf(message, len, "Post after timeout lost");
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Semaphore timeout", semaphore_timeout_test);
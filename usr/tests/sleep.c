@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2015 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/sched.h>
+#include "test.h"
+
+#define SLEEPING_TASKS  8
+
+/* Sleeping tasks wake once every SLEEP_PERIOD_US */
+#define SLEEP_PERIOD_US 10000
+
+#define TICK_US         (1000000 / CONFIG_SYSTICK_FREQ)
+#define TICK_NS         (NSEC_PER_SEC / CONFIG_SYSTICK_FREQ)
+
+/* Window to count CPU time over, in system ticks */
+#define WINDOW_TICKS    (CONFIG_SYSTICK_FREQ / 10)
+
+static volatile int sleepers_done;
+static atomic_t sleepers;
+
+static void sleeper(void) {
+    while (!sleepers_done) {
+        usleep(SLEEP_PERIOD_US);
+    }
+
+    atomic_dec(&sleepers);
+}
+
+/* Spin for WINDOW_TICKS, counting loop iterations we manage to run */
+static uint32_t spin_count(void) {
+    uint32_t end = system_ticks + WINDOW_TICKS;
+    uint32_t count = 0;
+
+    while ((int32_t) (end - system_ticks) > 0) {
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Sleeping tasks should not consume CPU time.  With SLEEPING_TASKS tasks at
+ * our priority sleeping, we should get nearly as much CPU time as without
+ * them.  If they were still scheduled while sleeping, each would take an
+ * equal share of the CPU.
+ */
+static int sleep_cpu_time_test(char *message, int len) {
+    uint32_t baseline, loaded;
+
+    baseline = spin_count();
+
+    sleepers_done = 0;
+    atomic_set(&sleepers, SLEEPING_TASKS);
+
+    for (int i = 0; i < SLEEPING_TASKS; i++) {
+        new_task(&sleeper, 1, 0);
+    }
+
+    /* Let the sleepers go to sleep */
+    usleep(SLEEP_PERIOD_US / 2);
+
+    loaded = spin_count();
+
+    sleepers_done = 1;
+    while (atomic_read(&sleepers)) {
+        usleep(SLEEP_PERIOD_US);
+    }
+
+    /* Allow up to 10% lost to wakeups and switching */
+    if (loaded < baseline - baseline / 10) {
+        scnprintf(message, len, "Reclaimed only %u of %u iterations "
+                  "with %d sleeping tasks", loaded, baseline, SLEEPING_TASKS);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Sleeping task CPU time", sleep_cpu_time_test);
+
+/* Sleep lengths to check, around the tick period */
+static const uint32_t sleep_lengths_us[] = {
+    1, TICK_US - 1, TICK_US, TICK_US + 1, 3 * TICK_US / 2, SLEEP_PERIOD_US,
+};
+
+/* Points within a tick to start sleeping at, in eighths of a tick */
+#define SLEEP_PHASES    8
+
+/*
+ * usleep() must never return before the requested time has passed, no
+ * matter how far into the current tick the sleep starts.
+ */
+static int sleep_duration_test(char *message, int len) {
+    for (int i = 0; i < ARRAY_LENGTH(sleep_lengths_us); i++) {
+        uint32_t usecs = sleep_lengths_us[i];
+
+        for (int phase = 0; phase < SLEEP_PHASES; phase++) {
+            uint64_t start, elapsed;
+
+            /* Start the sleep phase/SLEEP_PHASES of the way into a tick */
+            while (clock_monotonic_ns() % TICK_NS <
+                    phase * (TICK_NS / SLEEP_PHASES));
+
+            start = clock_monotonic_ns();
+            usleep(usecs);
+            elapsed = clock_monotonic_ns() - start;
+
+            if (elapsed < usecs * 1000ULL) {
+                scnprintf(message, len, "Slept only %u ns of %u us, "
+                          "starting %d/%d into a tick", (uint32_t) elapsed,
+                          usecs, phase, SLEEP_PHASES);
+                return FAILED;
+            }
+        }
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Sleep duration", sleep_duration_test);
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2013 F4OS Authors
+ * Copyright (C) 2013, 2014 F4OS Authors
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy of
  * this software and associated documentation files (the "Software"), to deal in
@@ -20,14 +20,34 @@
  * SOFTWARE.
  */
 
-#define BASE_REGION             0
-#define USER_MEM_REGION         1
-#define VECTFLASH_REGION        2
-#define RAM_REGION              4
-#define PRIV_PERIPH_REGION      5
-#define KERNEL_CODE_REGION      6
-#define KERNEL_MEM_REGION       7
+#include <stdint.h>
+#include <stdio.h>
+#include <arch/mpu.h>
+#include <kernel/sched.h>
+#include <kernel/sched_internals.h>
+#include "test.h"
 
-void mpu_setup(void) __attribute__((section(".kernel")));
-void mpu_stack_set(uint32_t *stack_base) __attribute__((section(".kernel")));
-uint16_t mpu_size(uint32_t size) __attribute__((section(".kernel")));
+/*
+ * The first access past the end of the stack of the running task must
+ * cause a memory management fault, while the rest of the stack remains
+ * accessible.  mpu_probe() catches the fault, rather than letting it bring
+ * down the system.
+ */
+static int stack_guard_test(char *message, int len) {
+    uint32_t *end = arch_sched_stack_guard_end(get_task_ctrl(curr_task));
+
+    if (mpu_probe(end)) {
+        scnprintf(message, len, "Lowest stack word 0x%x faulted", end);
+        return FAILED;
+    }
+
+    /* The word an overflowing stack writes next */
+    if (!mpu_probe(end - 1)) {
+        scnprintf(message, len, "Overflow into guard at 0x%x did not fault",
+                  end - 1);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("MPU stack guard", stack_guard_test);
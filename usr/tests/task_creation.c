@@ -20,8 +20,11 @@
  * SOFTWARE.
  */
 
-#include <kernel/sched.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <kernel/sched.h>
+#include <kernel/static_task.h>
 #include "test.h"
 
 volatile int task_created = 0;
@@ -45,3 +48,58 @@ int task_creation(char *message, int len) {
     return FAILED;
 }
 DEFINE_TEST("Task creation", task_creation);
+
+#define SMALL_STACK_WORDS   64
+#define STATIC_STACK_WORDS  128
+
+static volatile int small_stack_words = 0;
+static struct task_stats small_stats[32];
+
+static void small_stack_task(void) {
+    int count = task_stats(small_stats, 32);
+
+    for (int i = 0; i < count; i++) {
+        if (small_stats[i].fptr == small_stack_task) {
+            small_stack_words = small_stats[i].stack_size;
+        }
+    }
+}
+
+int task_creation_stack_size(char *message, int len) {
+    new_task_ex(&small_stack_task, 5, 0, SMALL_STACK_WORDS);
+
+    for (int i = 0; i < 100 && !small_stack_words; i++) {
+        usleep(1000);
+    }
+
+    if (small_stack_words != SMALL_STACK_WORDS) {
+        scnprintf(message, len, "Task stack is %d words, expected %d",
+                  small_stack_words, SMALL_STACK_WORDS);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Task creation with stack size", task_creation_stack_size);
+
+static volatile int static_task_ran = 0;
+
+static void static_test_task(void) {
+    static_task_ran = 1;
+}
+DEFINE_STATIC_TASK(static_test_task, 1, 0, STATIC_STACK_WORDS)
+
+int static_task_creation(char *message, int len) {
+    /* Started with the scheduler, but may not have run yet */
+    for (int i = 0; i < 100 && !static_task_ran; i++) {
+        usleep(1000);
+    }
+
+    if (!static_task_ran) {
+        strncpy(message, "Static task never ran", len);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Static task creation", static_task_creation);
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <compiler.h>
+#include <kernel/semaphore.h>
+#include <kernel/tasklet.h>
+#include "test.h"
+
+#define TASKLET_COUNT       16
+#define TASKLET_PERIOD_US   1000
+#define TASKLET_RUN_US      50000
+
+/* Releases expected in TASKLET_RUN_US, allowing for the partial periods */
+#define TASKLET_RUNS_MIN    (TASKLET_RUN_US / TASKLET_PERIOD_US - 2)
+#define TASKLET_RUNS_MAX    (TASKLET_RUN_US / TASKLET_PERIOD_US + 2)
+
+struct counter {
+    struct tasklet  tasklet;
+    volatile int    runs;
+};
+
+static struct counter counters[TASKLET_COUNT];
+
+static void count(struct tasklet *tasklet) {
+    struct counter *counter = container_of(tasklet, struct counter, tasklet);
+
+    counter->runs++;
+}
+
+/* Many periodic tasklets all run at their period, then stop */
+static int tasklet_periodic_test(char *message, int len) {
+    int runs[TASKLET_COUNT];
+
+    for (int i = 0; i < TASKLET_COUNT; i++) {
+        init_tasklet(&counters[i].tasklet, count, TASKLET_PERIOD_US);
+        counters[i].runs = 0;
+    }
+
+    for (int i = 0; i < TASKLET_COUNT; i++) {
+        tasklet_start(&counters[i].tasklet, 0);
+    }
+
+    usleep(TASKLET_RUN_US);
+
+    for (int i = 0; i < TASKLET_COUNT; i++) {
+        if (tasklet_stop(&counters[i].tasklet) != 1) {
+            scnprintf(message, len, "Tasklet %d was not started", i);
+            return FAILED;
+        }
+    }
+
+    for (int i = 0; i < TASKLET_COUNT; i++) {
+        runs[i] = counters[i].runs;
+
+        if (runs[i] < TASKLET_RUNS_MIN || runs[i] > TASKLET_RUNS_MAX) {
+            scnprintf(message, len, "Tasklet %d ran %d times in %d us, "
+                      "expected %d to %d", i, runs[i], TASKLET_RUN_US,
+                      TASKLET_RUNS_MIN, TASKLET_RUNS_MAX);
+            return FAILED;
+        }
+
+        if (counters[i].tasklet.overruns) {
+            scnprintf(message, len, "Tasklet %d overran %u times", i,
+                      counters[i].tasklet.overruns);
+            return FAILED;
+        }
+    }
+
+    /* A release already waiting may still run, but no more */
+    usleep(5 * TASKLET_PERIOD_US);
+
+    for (int i = 0; i < TASKLET_COUNT; i++) {
+        if (counters[i].runs > runs[i] + 1) {
+            scnprintf(message, len, "Tasklet %d ran %d times after stop", i,
+                      counters[i].runs - runs[i]);
+            return FAILED;
+        }
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Periodic tasklets", tasklet_periodic_test);
+
+static struct semaphore oneshot_sem = INIT_SEMAPHORE(oneshot_sem, 0);
+static volatile int oneshot_runs;
+
+static void oneshot(struct tasklet *tasklet) {
+    oneshot_runs++;
+    sem_post(&oneshot_sem);
+}
+
+/* One-shot tasklets run once, after their delay */
+static int tasklet_oneshot_test(char *message, int len) {
+    struct tasklet tasklet = INIT_TASKLET(tasklet, oneshot, 0);
+    uint64_t start, elapsed;
+
+    oneshot_runs = 0;
+    init_semaphore(&oneshot_sem, 0);
+
+    start = system_time(0);
+    tasklet_start(&tasklet, 2000);
+
+    if (sem_wait(&oneshot_sem, 100000)) {
+        scnprintf(message, len, "Tasklet never ran");
+        return FAILED;
+    }
+
+    elapsed = system_time(start);
+    if (elapsed < 2000) {
+        scnprintf(message, len, "Tasklet ran after %u us, expected 2000 us",
+                  (uint32_t) elapsed);
+        return FAILED;
+    }
+
+    usleep(5000);
+
+    if (oneshot_runs != 1) {
+        scnprintf(message, len, "Tasklet ran %d times", oneshot_runs);
+        return FAILED;
+    }
+
+    if (tasklet_stop(&tasklet) != 0) {
+        scnprintf(message, len, "Tasklet still started after running");
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("One-shot tasklet", tasklet_oneshot_test);
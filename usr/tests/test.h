@@ -28,7 +28,9 @@
 /* Tests return 0 on pass, else on error.
  * The first arguement is a buffer to copy
  * an error message into, whose length is the
- * second arguement */
+ * second arguement.  The message is printed
+ * whether the test passes or fails, so passing
+ * benchmarks may report results in it. */
 struct test {
     char *name;
     int (*func)(char *, int);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2013, 2014 F4OS Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <kernel/workqueue.h>
+#include "test.h"
+
+#define WORK_REQUEUES   10
+
+static volatile int work_order[3];
+static volatile int work_runs;
+static volatile int work_duplicate;
+
+static void second_work_func(struct work *work) {
+    work_order[work_runs++] = 2;
+}
+
+static struct work second_work = INIT_WORK(second_work_func);
+
+static void first_work_func(struct work *work) {
+    work_order[work_runs++] = 1;
+
+    /* Queued twice while pending, so it must only run once */
+    queue_work(&second_work);
+    work_duplicate = !queue_work(&second_work);
+}
+
+static struct work first_work = INIT_WORK(first_work_func);
+
+static int workqueue_order_test(char *message, int len) {
+    work_runs = 0;
+    work_duplicate = 0;
+
+    queue_work(&first_work);
+    usleep(10000);
+
+    if (work_duplicate) {
+        scnprintf(message, len, "Pending work queued again");
+        return FAILED;
+    }
+
+    if (work_runs != 2 || work_order[0] != 1 || work_order[1] != 2) {
+        scnprintf(message, len, "%d work items ran, expected 2", work_runs);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Work queue order", workqueue_order_test);
+
+static volatile int requeue_runs;
+
+static void requeue_work_func(struct work *work) {
+    if (++requeue_runs < WORK_REQUEUES) {
+        queue_work(work);
+    }
+}
+
+static struct work requeue_work = INIT_WORK(requeue_work_func);
+
+static int workqueue_requeue_test(char *message, int len) {
+    requeue_runs = 0;
+
+    queue_work(&requeue_work);
+    usleep(10000);
+
+    if (requeue_runs != WORK_REQUEUES) {
+        scnprintf(message, len, "Work ran %d times, expected %d",
+                  requeue_runs, WORK_REQUEUES);
+        return FAILED;
+    }
+
+    return PASSED;
+}
+DEFINE_TEST("Work queue requeue", workqueue_requeue_test);